@@ -0,0 +1,255 @@
+// Measures the cost of every basic Registry operation from 1k to 1M entities,
+// in nanoseconds and heap allocations per operation, for both storage modes.
+// Usage: ecs_benchmark [--output <results.txt>] [--baseline <results.txt>]
+//   --output    saves the results, to compare a later run of the storage against
+//   --baseline  prints the change of each result relative to a saved run
+#include "../src/ECS/ECS.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Sytems/MovementSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <tuple>
+#include <vector>
+
+const int ENTITY_COUNTS[] = {1000, 10000, 100000, 1000000};
+
+// Small entity counts are repeated on fresh registries until each operation ran at least this many times
+const int MIN_OPERATIONS = 50000;
+
+// Heap allocations made by the measuring thread, the logger thread keeps its own count
+thread_local long long numAllocations = 0;
+
+void *operator new(std::size_t size)
+{
+  numAllocations++;
+  if (void *pointer = std::malloc(size ? size : 1))
+  {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  numAllocations++;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  if (void *pointer = std::aligned_alloc(align, (size + align - 1) / align * align))
+  {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+enum Operation
+{
+  OPERATION_CREATE_ENTITY,
+  OPERATION_ADD_COMPONENT,
+  OPERATION_UPDATE,
+  OPERATION_GET_COMPONENT,
+  OPERATION_HAS_COMPONENT,
+  OPERATION_SYSTEM_ITERATION,
+  OPERATION_KILL_ENTITY,
+  NUM_OPERATIONS
+};
+
+const char *OPERATION_NAMES[NUM_OPERATIONS] = {
+    "CreateEntity",
+    "AddComponent",
+    "Registry::Update",
+    "GetComponent",
+    "HasComponent",
+    "SystemIteration",
+    "KillEntity+Update",
+};
+
+struct Measurement
+{
+  double nanoseconds = 0.0;
+  long long allocations = 0;
+  long long operations = 0;
+};
+
+// Results of a previous run, by operation, storage and entity count
+using Baseline = std::map<std::tuple<std::string, std::string, int>, std::pair<double, double>>;
+
+// Keeps the compiler from optimizing the lookups away
+volatile float sink = 0.0f;
+
+template <typename TFunction>
+void Measure(Measurement &measurement, long long numOperations, TFunction function)
+{
+  const long long startAllocations = numAllocations;
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const auto end = std::chrono::steady_clock::now();
+  measurement.nanoseconds += std::chrono::duration<double, std::nano>(end - start).count();
+  measurement.allocations += numAllocations - startAllocations;
+  measurement.operations += numOperations;
+}
+
+// Goes through the whole life of numEntities entities on a fresh registry
+void RunRound(StorageMode storageMode, int numEntities, Measurement *measurements)
+{
+  Registry registry(storageMode);
+  registry.AddSystem<MovementSystem>();
+  MovementSystem &movementSystem = registry.GetSystem<MovementSystem>();
+
+  std::vector<Entity> entities;
+  entities.reserve(numEntities);
+
+  Measure(measurements[OPERATION_CREATE_ENTITY], numEntities, [&]()
+          {
+    for (int i = 0; i < numEntities; i++)
+    {
+      entities.push_back(registry.CreateEntity());
+    } });
+
+  Measure(measurements[OPERATION_ADD_COMPONENT], 2LL * numEntities, [&]()
+          {
+    for (Entity &entity : entities)
+    {
+      entity.AddComponent<TransformComponent>(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0);
+      entity.AddComponent<RigidBodyComponent>(glm::vec2(100.0, 0.0));
+    } });
+
+  Measure(measurements[OPERATION_UPDATE], numEntities, [&]()
+          { registry.Update(); });
+
+  Measure(measurements[OPERATION_GET_COMPONENT], numEntities, [&]()
+          {
+    float sum = 0.0f;
+    for (Entity &entity : entities)
+    {
+      sum += entity.GetComponent<TransformComponent>().scale.x;
+    }
+    sink = sum; });
+
+  Measure(measurements[OPERATION_HAS_COMPONENT], numEntities, [&]()
+          {
+    int count = 0;
+    for (Entity &entity : entities)
+    {
+      count += entity.HasComponent<RigidBodyComponent>();
+    }
+    sink = count; });
+
+  Measure(measurements[OPERATION_SYSTEM_ITERATION], numEntities, [&]()
+          { movementSystem.Update(1.0 / 120.0); });
+
+  Measure(measurements[OPERATION_KILL_ENTITY], numEntities, [&]()
+          {
+    for (Entity &entity : entities)
+    {
+      entity.Kill();
+    }
+    registry.Update(); });
+}
+
+void Run(StorageMode storageMode, const char *storageName, const Baseline &baseline, FILE *output)
+{
+  for (const int numEntities : ENTITY_COUNTS)
+  {
+    Measurement measurements[NUM_OPERATIONS];
+    const int numRounds = numEntities < MIN_OPERATIONS ? MIN_OPERATIONS / numEntities : 1;
+    for (int round = 0; round < numRounds; round++)
+    {
+      RunRound(storageMode, numEntities, measurements);
+    }
+
+    for (int operation = 0; operation < NUM_OPERATIONS; operation++)
+    {
+      const Measurement &measurement = measurements[operation];
+      const double nanosecondsPerOperation = measurement.nanoseconds / measurement.operations;
+      const double allocationsPerOperation = static_cast<double>(measurement.allocations) / measurement.operations;
+
+      std::printf("%-10s %7d entities | %-17s | %8.1f ns/op | %6.3f allocs/op",
+                  storageName, numEntities, OPERATION_NAMES[operation], nanosecondsPerOperation, allocationsPerOperation);
+
+      const auto previous = baseline.find({OPERATION_NAMES[operation], storageName, numEntities});
+      if (previous != baseline.end())
+      {
+        std::printf(" | %+6.1f%% time | %+6.3f allocs/op",
+                    (nanosecondsPerOperation / previous->second.first - 1.0) * 100.0,
+                    allocationsPerOperation - previous->second.second);
+      }
+      std::printf("\n");
+
+      if (output)
+      {
+        std::fprintf(output, "%s %s %d %f %f\n",
+                     OPERATION_NAMES[operation], storageName, numEntities, nanosecondsPerOperation, allocationsPerOperation);
+      }
+    }
+  }
+}
+
+Baseline LoadBaseline(const char *path)
+{
+  Baseline baseline;
+  FILE *file = std::fopen(path, "r");
+  if (!file)
+  {
+    std::fprintf(stderr, "Error opening the baseline %s\n", path);
+    return baseline;
+  }
+
+  char operation[64];
+  char storage[64];
+  int numEntities;
+  double nanoseconds;
+  double allocations;
+  while (std::fscanf(file, "%63s %63s %d %lf %lf", operation, storage, &numEntities, &nanoseconds, &allocations) == 5)
+  {
+    baseline[{operation, storage, numEntities}] = {nanoseconds, allocations};
+  }
+  std::fclose(file);
+  return baseline;
+}
+
+int main(int argc, char *argv[])
+{
+  Baseline baseline;
+  FILE *output = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--baseline" && i + 1 < argc)
+    {
+      baseline = LoadBaseline(argv[++i]);
+    }
+    else if (argument == "--output" && i + 1 < argc)
+    {
+      output = std::fopen(argv[++i], "w");
+      if (!output)
+      {
+        std::fprintf(stderr, "Error opening the output %s\n", argv[i]);
+        return 1;
+      }
+    }
+    else
+    {
+      std::fprintf(stderr, "Unknown argument: %s\n", argument.c_str());
+      return 1;
+    }
+  }
+
+  Run(StorageMode::SparseSet, "sparse-set", baseline, output);
+  Run(StorageMode::Archetype, "archetype", baseline, output);
+
+  if (output)
+  {
+    std::fclose(output);
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Spawns and kills waves of short-lived entities (think bullets) millions of
+// times, and checks that the registry keeps reusing the same entity ids so
+// its memory stays flat no matter how long the game runs.
+#include "../src/ECS/ECS.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Sytems/MovementSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sys/resource.h>
+
+const int ENTITIES_PER_WAVE = 10000;
+const int NUM_WAVES = 200;
+
+long MaxResidentKilobytes()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+int main()
+{
+  Registry registry;
+  registry.AddSystem<MovementSystem>();
+  std::vector<Entity> wave;
+  wave.reserve(ENTITIES_PER_WAVE);
+
+  long residentAfterFirstWaves = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int waveIndex = 0; waveIndex < NUM_WAVES; waveIndex++)
+  {
+    for (int i = 0; i < ENTITIES_PER_WAVE; i++)
+    {
+      Entity bullet = registry.CreateEntity();
+      bullet.AddComponent<TransformComponent>(glm::vec2(i, waveIndex), glm::vec2(1.0, 1.0), 0.0);
+      bullet.AddComponent<RigidBodyComponent>(glm::vec2(100.0, 0.0));
+      wave.push_back(bullet);
+    }
+    registry.Update();
+    registry.GetSystem<MovementSystem>().Update(1.0 / 60.0);
+
+    for (auto bullet : wave)
+    {
+      bullet.Kill();
+    }
+    registry.Update();
+
+    // The handles of the killed bullets must now be detected as stale
+    if (wave.front().HasComponent<TransformComponent>())
+    {
+      std::cerr << "Stale entity handle was not detected" << std::endl;
+      return 1;
+    }
+    wave.clear();
+
+    if (waveIndex == 10)
+    {
+      residentAfterFirstWaves = MaxResidentKilobytes();
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const long totalEntities = static_cast<long>(ENTITIES_PER_WAVE) * NUM_WAVES;
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  std::printf("%ld entities spawned and killed in %.2f s (%.0f ns per entity)\n",
+              totalEntities, seconds, seconds * 1e9 / totalEntities);
+  std::printf("max resident memory: %ld KiB after 10 waves, %ld KiB after %d waves\n",
+              residentAfterFirstWaves, MaxResidentKilobytes(), NUM_WAVES);
+  std::printf("live entities: %d\n", registry.GetNumEntities());
+
+  // Memory is flat if the later waves didn't grow the process at all (allowing some allocator noise)
+  const bool isFlat = MaxResidentKilobytes() <= residentAfterFirstWaves + 1024;
+  std::printf("%s\n", isFlat ? "memory is flat" : "memory keeps growing!");
+  return isFlat ? 0 : 1;
+}
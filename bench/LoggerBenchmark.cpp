@@ -0,0 +1,118 @@
+// Measures the latency of Logger::Log as seen by the calling threads, with
+// several threads logging at the same time, and compares building the message
+// at the call site with the deferred formatting of Logger::Logf.
+// The writer thread sends the messages to a file so the console doesn't slow it down.
+#include "../src/Logger/Logger.h"
+#include "../src/Logger/LogHistory.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+const int MESSAGES_PER_THREAD = 20000;
+
+void Run(int numThreads)
+{
+  std::vector<std::vector<double>> latencies(numThreads);
+  std::vector<std::thread> threads;
+  const size_t droppedBefore = Logger::GetNumDropped();
+
+  for (int threadIndex = 0; threadIndex < numThreads; threadIndex++)
+  {
+    threads.emplace_back([threadIndex, &latencies]()
+                         {
+      std::vector<double> &threadLatencies = latencies[threadIndex];
+      threadLatencies.reserve(MESSAGES_PER_THREAD);
+      const std::string message = "Thread " + std::to_string(threadIndex) + " spawned a projectile at x = 124.5, y = 87.25";
+
+      for (int i = 0; i < MESSAGES_PER_THREAD; i++)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        Logger::Log(message);
+        const auto end = std::chrono::steady_clock::now();
+        threadLatencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+      } });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  Logger::Flush();
+
+  std::vector<double> allLatencies;
+  for (auto &threadLatencies : latencies)
+  {
+    allLatencies.insert(allLatencies.end(), threadLatencies.begin(), threadLatencies.end());
+  }
+  std::sort(allLatencies.begin(), allLatencies.end());
+  double sum = 0.0;
+  for (double latency : allLatencies)
+  {
+    sum += latency;
+  }
+
+  // A dropped call returns early and is cheaper, so the latency only means something next to the drop rate
+  const size_t numDropped = Logger::GetNumDropped() - droppedBefore;
+  std::printf("%d threads | p50 %5.0f ns, %5.1f%% dropped | mean %7.0f ns | p99 %8.0f ns | max %9.0f ns\n",
+              numThreads, allLatencies[allLatencies.size() / 2], 100.0 * numDropped / allLatencies.size(),
+              sum / allLatencies.size(), allLatencies[allLatencies.size() * 99 / 100], allLatencies.back());
+}
+
+// CPU time spent by the calling thread only, leaving out the writer thread
+double ThreadCpuNanoseconds()
+{
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+// Logs in bursts that fit in the queue, so that no message gets dropped
+template <typename TFunction>
+double MeasureCallSiteNanoseconds(TFunction log)
+{
+  const int burstSize = 4096;
+  const int numBursts = 20;
+  double total = 0.0;
+  for (int burst = 0; burst < numBursts; burst++)
+  {
+    const double start = ThreadCpuNanoseconds();
+    for (int i = 0; i < burstSize; i++)
+    {
+      log(i);
+    }
+    total += ThreadCpuNanoseconds() - start;
+    Logger::Flush();
+  }
+  return total / (burstSize * numBursts);
+}
+
+int main()
+{
+  Logger::SetConsoleOutput(false);
+  Logger::SetFileOutput("logger_benchmark.log");
+
+  for (int numThreads : {1, 2, 4, 8})
+  {
+    Run(numThreads);
+  }
+
+  const int componentId = 3;
+  const double eagerTime = MeasureCallSiteNanoseconds([componentId](int entityId)
+                                                      { Logger::Log("Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId)); });
+  const double deferredTime = MeasureCallSiteNanoseconds([componentId](int entityId)
+                                                         { Logger::Logf("Component id = %d was added to entity id %d", componentId, entityId); });
+  std::printf("call site | Log(std::string + std::to_string) %5.0f ns | Logf(format, args) %5.0f ns | x%.1f\n",
+              eagerTime, deferredTime, eagerTime / deferredTime);
+
+  // The history must stay bounded however many messages went through
+  Logger::Flush();
+  const LogHistory &history = Logger::GetHistory();
+  std::printf("history   | %zu messages kept (%zu errors) out of a capacity of %zu\n",
+              history.GetNumEntries(), history.GetNumEntries(LOG_ERROR), LOG_HISTORY_CAPACITY);
+
+  Logger::SetFileOutput("");
+  std::remove("logger_benchmark.log");
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Measures the frame time and the number of draw calls of RenderSystem at 50k
+// sprites, comparing a draw call per entity with the batched frame, for plain
+// rectangles and for sprites spread over a few textures.
+// Renders with SDL's software renderer into a surface, so it needs no window.
+#include "../src/ECS/ECS.h"
+#include "../src/AssetStore/AssetStore.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/SpriteComponent.h"
+#include "../src/Sytems/RenderSystem.h"
+#include <SDL.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+const int NUM_SPRITES = 50000;
+const int NUM_FRAMES = 20;
+const int SURFACE_WIDTH = 800;
+const int SURFACE_HEIGHT = 600;
+
+template <typename TFunction>
+double MeasureFrameMilliseconds(TFunction frame)
+{
+  // Warm up the caches before measuring
+  frame();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < NUM_FRAMES; i++)
+  {
+    frame();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() / NUM_FRAMES;
+}
+
+// Sprites without texture when textureIds is empty, each one picking one of them otherwise
+void Run(StorageMode storageMode, const char *storageName, SDL_Renderer *renderer,
+         const AssetStore &assetStore, const std::vector<int> &textureIds)
+{
+  Registry registry(storageMode);
+  registry.AddSystem<RenderSystem>();
+
+  std::mt19937 random(42);
+  std::uniform_real_distribution<float> x(0.0f, SURFACE_WIDTH);
+  std::uniform_real_distribution<float> y(0.0f, SURFACE_HEIGHT);
+  for (int i = 0; i < NUM_SPRITES; i++)
+  {
+    Entity entity = registry.CreateEntity();
+    entity.AddComponent<TransformComponent>(glm::vec2(x(random), y(random)), glm::vec2(1.0, 1.0), 0.0);
+    if (textureIds.empty())
+    {
+      entity.AddComponent<SpriteComponent>(4, 4);
+    }
+    else
+    {
+      entity.AddComponent<SpriteComponent>(32, 32, textureIds[i % textureIds.size()]);
+    }
+  }
+  registry.Update();
+
+  RenderSystem &renderSystem = registry.GetSystem<RenderSystem>();
+  const SDL_Rect camera = {0, 0, SURFACE_WIDTH, SURFACE_HEIGHT};
+
+  int perEntityDrawCalls = 0;
+  const double perEntityTime = MeasureFrameMilliseconds([&]()
+                                                        {
+    // What RenderSystem::Update used to do every frame, and its equivalent for the textures
+    perEntityDrawCalls = 0;
+    SDL_RenderClear(renderer);
+    for (auto [entity, transform, sprite] : registry.View<TransformComponent, SpriteComponent>())
+    {
+      SDL_Rect objRect = {
+          static_cast<int>(transform.position.x),
+          static_cast<int>(transform.position.y),
+          sprite.width,
+          sprite.height};
+
+      if (sprite.textureId == NO_TEXTURE)
+      {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderFillRect(renderer, &objRect);
+      }
+      else
+      {
+        SDL_Rect srcRect = {sprite.srcX, sprite.srcY, sprite.width, sprite.height};
+        SDL_RenderCopy(renderer, assetStore.GetTexture(sprite.textureId), &srcRect, &objRect);
+      }
+      perEntityDrawCalls++;
+    }
+    SDL_RenderPresent(renderer); });
+
+  const double batchedTime = MeasureFrameMilliseconds([&]()
+                                                      {
+    SDL_RenderClear(renderer);
+    renderSystem.Update(renderer, assetStore, camera, 1.0);
+    SDL_RenderPresent(renderer); });
+
+  std::printf("%-10s %-8s %d sprites | per entity %8.2f ms/frame %6d draw calls | batched %8.2f ms/frame %6d draw calls | x%.1f\n",
+              storageName, textureIds.empty() ? "plain" : "textured", NUM_SPRITES, perEntityTime, perEntityDrawCalls,
+              batchedTime, renderSystem.GetNumDrawCalls(), perEntityTime / batchedTime);
+}
+
+int main()
+{
+  SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, SURFACE_WIDTH, SURFACE_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+  SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+  if (renderer == NULL)
+  {
+    std::fprintf(stderr, "Error creating the software renderer: %s\n", SDL_GetError());
+    return 1;
+  }
+
+  AssetStore assetStore;
+  std::vector<int> textureIds;
+  for (const char *path : {"./assets/images/tank-panther-right.png",
+                           "./assets/images/tank-tiger-right.png",
+                           "./assets/images/truck-ford-right.png",
+                           "./assets/images/takeoff-base.png"})
+  {
+    const int textureId = assetStore.AddTexture(renderer, path);
+    if (textureId != NO_TEXTURE)
+    {
+      textureIds.push_back(textureId);
+    }
+  }
+
+  Run(StorageMode::SparseSet, "sparse-set", renderer, assetStore, {});
+  Run(StorageMode::Archetype, "archetype", renderer, assetStore, {});
+  if (!textureIds.empty())
+  {
+    Run(StorageMode::SparseSet, "sparse-set", renderer, assetStore, textureIds);
+    Run(StorageMode::Archetype, "archetype", renderer, assetStore, textureIds);
+  }
+
+  assetStore.ClearAssets();
+  SDL_DestroyRenderer(renderer);
+  SDL_FreeSurface(surface);
+  return 0;
+}
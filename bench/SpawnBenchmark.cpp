@@ -0,0 +1,57 @@
+// Compares spawning a wave of 100k entities one by one (CreateEntity followed
+// by three AddComponent calls) with Registry::Reserve + Registry::CreateEntities.
+#include "../src/ECS/ECS.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Components/SpriteComponent.h"
+#include "../src/Sytems/MovementSystem.h"
+#include <chrono>
+#include <cstdio>
+
+const int NUM_ENTITIES = 100000;
+
+template <typename TFunction>
+double MeasureMilliseconds(TFunction function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void Run(StorageMode storageMode, const char *storageName)
+{
+  Registry perEntityRegistry(storageMode);
+  perEntityRegistry.AddSystem<MovementSystem>();
+  const double perEntityTime = MeasureMilliseconds([&]()
+                                                   {
+    for (int i = 0; i < NUM_ENTITIES; i++)
+    {
+      Entity entity = perEntityRegistry.CreateEntity();
+      entity.AddComponent<TransformComponent>(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0);
+      entity.AddComponent<RigidBodyComponent>(glm::vec2(100.0, 0.0));
+      entity.AddComponent<SpriteComponent>(4, 4);
+    }
+    perEntityRegistry.Update(); });
+
+  Registry bulkRegistry(storageMode);
+  bulkRegistry.AddSystem<MovementSystem>();
+  const double bulkTime = MeasureMilliseconds([&]()
+                                              {
+    bulkRegistry.Reserve(NUM_ENTITIES);
+    bulkRegistry.CreateEntities(NUM_ENTITIES,
+                                TransformComponent(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0),
+                                RigidBodyComponent(glm::vec2(100.0, 0.0)),
+                                SpriteComponent(4, 4));
+    bulkRegistry.Update(); });
+
+  std::printf("%-10s %d entities | per entity %8.1f ms | bulk %8.1f ms | x%.1f\n",
+              storageName, NUM_ENTITIES, perEntityTime, bulkTime, perEntityTime / bulkTime);
+}
+
+int main()
+{
+  Run(StorageMode::SparseSet, "sparse-set");
+  Run(StorageMode::Archetype, "archetype");
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Measures loading a 4096x4096 tilemap from its CSV text, from the memory mapped
+// binary format and from the compressed binary format: time to load, time of a
+// first pass over all the tiles, and the heap memory the tiles take.
+// The maps are written to the working directory and removed at the end.
+#include "../src/Tilemap/TilemapFormat.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const int MAP_SIZE = 4096;
+const char *const CSV_PATH = "./tilemap_benchmark.map";
+const char *const BINARY_PATH = "./tilemap_benchmark.tmb";
+const char *const COMPRESSED_PATH = "./tilemap_benchmark_compressed.tmb";
+
+template <typename TFunction>
+double MeasureMilliseconds(TFunction function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Keeps the compiler from optimizing the passes away
+volatile uint64_t sink = 0;
+
+void SumTiles(const uint16_t *tiles)
+{
+  uint64_t sum = 0;
+  for (size_t i = 0; i < static_cast<size_t>(MAP_SIZE) * MAP_SIZE; i++)
+  {
+    sum += tiles[i];
+  }
+  sink = sum;
+}
+
+long FileSize(const char *path)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return static_cast<long>(file.tellg());
+}
+
+void Report(const char *name, const char *path, double loadTime, double passTime, size_t heapBytes)
+{
+  std::printf("%-17s | file %7.1f MiB | load %8.1f ms | first pass %6.1f ms | heap %6.1f MiB\n",
+              name, FileSize(path) / 1048576.0, loadTime, passTime, heapBytes / 1048576.0);
+}
+
+int main()
+{
+  // Terrain like map: runs of the same tile, as most tilemaps have
+  std::vector<uint16_t> tiles(static_cast<size_t>(MAP_SIZE) * MAP_SIZE);
+  std::mt19937 random(42);
+  for (size_t i = 0; i < tiles.size(); i++)
+  {
+    tiles[i] = i % 8 == 0 ? random() % 30 : tiles[i - 1];
+  }
+  {
+    std::ofstream csv(CSV_PATH);
+    for (int y = 0; y < MAP_SIZE; y++)
+    {
+      for (int x = 0; x < MAP_SIZE; x++)
+      {
+        csv << (tiles[y * MAP_SIZE + x] < 10 ? "0" : "") << tiles[y * MAP_SIZE + x] << (x + 1 < MAP_SIZE ? "," : "\n");
+      }
+    }
+  }
+  std::string error;
+  WriteBinaryTilemap(BINARY_PATH, MAP_SIZE, MAP_SIZE, {tiles}, false, error);
+  WriteBinaryTilemap(COMPRESSED_PATH, MAP_SIZE, MAP_SIZE, {tiles}, true, error);
+
+  {
+    std::vector<uint16_t> csvTiles;
+    size_t textSize = 0;
+    const double loadTime = MeasureMilliseconds([&]()
+                                                {
+      std::ifstream file(CSV_PATH);
+      std::stringstream text;
+      text << file.rdbuf();
+      const std::string content = text.str();
+      textSize = content.size();
+      int width;
+      int height;
+      ParseTilemapCsv(content, csvTiles, width, height, error); });
+    const double passTime = MeasureMilliseconds([&]()
+                                                { SumTiles(csvTiles.data()); });
+    // The text is held twice while parsing, by the stream and by the string
+    Report("csv", CSV_PATH, loadTime, passTime, 2 * textSize + csvTiles.size() * sizeof(uint16_t));
+  }
+
+  {
+    BinaryTilemapFile file;
+    const uint16_t *binaryTiles = nullptr;
+    const double loadTime = MeasureMilliseconds([&]()
+                                                {
+      file.Open(BINARY_PATH, error);
+      binaryTiles = file.GetLayerTiles(0); });
+    const double passTime = MeasureMilliseconds([&]()
+                                                { SumTiles(binaryTiles); });
+    Report("binary (mmap)", BINARY_PATH, loadTime, passTime, 0);
+  }
+
+  {
+    BinaryTilemapFile file;
+    std::vector<uint16_t> decompressedTiles;
+    const double loadTime = MeasureMilliseconds([&]()
+                                                {
+      file.Open(COMPRESSED_PATH, error);
+      file.DecompressLayer(0, decompressedTiles); });
+    const double passTime = MeasureMilliseconds([&]()
+                                                { SumTiles(decompressedTiles.data()); });
+    Report("binary compressed", COMPRESSED_PATH, loadTime, passTime, decompressedTiles.size() * sizeof(uint16_t));
+  }
+
+  std::remove(CSV_PATH);
+  std::remove(BINARY_PATH);
+  std::remove(COMPRESSED_PATH);
+  return 0;
+}
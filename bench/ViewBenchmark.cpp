@@ -0,0 +1,71 @@
+// Measures the per-frame cost of iterating the entities of MovementSystem,
+// comparing the former copy of GetSystemEntities() + GetComponent lookups
+// with the zero-copy component views, for both storage modes.
+#include "../src/ECS/ECS.h"
+#include "../src/Components/TransformComponent.h"
+#include "../src/Components/RigidBodyComponent.h"
+#include "../src/Sytems/MovementSystem.h"
+#include <chrono>
+#include <cstdio>
+
+const int NUM_FRAMES = 20;
+
+template <typename TFunction>
+double MeasureFrameMicroseconds(TFunction frame)
+{
+  // Warm up the caches before measuring
+  frame();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < NUM_FRAMES; i++)
+  {
+    frame();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / NUM_FRAMES;
+}
+
+void Run(StorageMode storageMode, const char *storageName, int numEntities)
+{
+  Registry registry(storageMode);
+  registry.AddSystem<MovementSystem>();
+
+  for (int i = 0; i < numEntities; i++)
+  {
+    Entity entity = registry.CreateEntity();
+    entity.AddComponent<TransformComponent>(glm::vec2(i, i), glm::vec2(1.0, 1.0), 0.0);
+    entity.AddComponent<RigidBodyComponent>(glm::vec2(1.0, 0.5));
+  }
+  registry.Update();
+
+  MovementSystem &movementSystem = registry.GetSystem<MovementSystem>();
+  const double deltaTime = 1.0 / 60.0;
+
+  const double copyTime = MeasureFrameMicroseconds([&]()
+                                                   {
+    // What MovementSystem::Update used to do every frame
+    std::vector<Entity> entities = movementSystem.GetSystemEntities();
+    for (auto entity : entities)
+    {
+      auto &transform = entity.GetComponent<TransformComponent>();
+      const auto rigidBody = entity.GetComponent<RigidBodyComponent>();
+      transform.position.x += rigidBody.velocity.x * deltaTime;
+      transform.position.y += rigidBody.velocity.y * deltaTime;
+    } });
+
+  const double viewTime = MeasureFrameMicroseconds([&]()
+                                                   { movementSystem.Update(deltaTime); });
+
+  std::printf("%-10s %9d entities | copy + lookups %10.1f us/frame | view %10.1f us/frame | x%.1f\n",
+              storageName, numEntities, copyTime, viewTime, copyTime / viewTime);
+}
+
+int main()
+{
+  for (int numEntities : {10000, 100000, 1000000})
+  {
+    Run(StorageMode::SparseSet, "sparse-set", numEntities);
+    Run(StorageMode::Archetype, "archetype", numEntities);
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+#include "AssetStore.h"
+#include "../Logger/Logger.h"
+#include <SDL_image.h>
+#include <fstream>
+#include <sstream>
+
+AssetStore::AssetStore() : textures(1)
+{
+  Logger::Log("AssetStore constructor called!");
+}
+
+AssetStore::~AssetStore()
+{
+  ClearAssets();
+  Logger::Log("AssetStore destructor called!");
+}
+
+void AssetStore::ClearAssets()
+{
+  for (int textureId = 1; textureId < GetNumTextureIds(); textureId++)
+  {
+    UnloadTexture(textureId);
+  }
+  atlasSprites.clear();
+}
+
+int AssetStore::AddTexture(SDL_Renderer *renderer, const std::string &path)
+{
+  const auto loaded = textureIds.find(path);
+  if (loaded != textureIds.end())
+  {
+    return loaded->second;
+  }
+
+  SDL_Texture *texture = IMG_LoadTexture(renderer, path.c_str());
+  if (texture == NULL)
+  {
+    Logger::Errf("Error loading the texture %s: %s", path, IMG_GetError());
+    return NO_TEXTURE;
+  }
+
+  TextureAsset asset;
+  asset.texture = texture;
+  asset.path = path;
+  SDL_QueryTexture(texture, NULL, NULL, &asset.width, &asset.height);
+
+  const int textureId = GetNumTextureIds();
+  textures.push_back(asset);
+  textureIds.emplace(path, textureId);
+  Logger::Logf("Texture %s loaded with id %d", path, textureId);
+  return textureId;
+}
+
+void AssetStore::UnloadTexture(int textureId)
+{
+  if (textureId <= NO_TEXTURE || textureId >= GetNumTextureIds() || textures[textureId].texture == nullptr)
+  {
+    return;
+  }
+
+  TextureAsset &asset = textures[textureId];
+  SDL_DestroyTexture(asset.texture);
+  asset.texture = nullptr;
+  textureIds.erase(asset.path);
+}
+
+bool AssetStore::AddAtlas(SDL_Renderer *renderer, const std::string &listPath)
+{
+  std::ifstream list(listPath);
+  if (!list)
+  {
+    return false;
+  }
+  const std::string directory = listPath.substr(0, listPath.find_last_of('/') + 1);
+
+  // Texture id of each page
+  std::vector<int> pageTextureIds;
+  // Pages this call loaded, the ones already loaded before stay if the atlas fails
+  std::vector<int> newTextureIds;
+  // Only added to atlasSprites once the whole atlas is loaded
+  std::vector<std::pair<std::string, AtlasSprite>> sprites;
+  bool isValid = true;
+  std::string line;
+  while (std::getline(list, line))
+  {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    if (kind == "page")
+    {
+      std::string pageName;
+      fields >> pageName;
+      const bool isLoaded = textureIds.count(directory + pageName) > 0;
+      const int textureId = AddTexture(renderer, directory + pageName);
+      if (textureId == NO_TEXTURE)
+      {
+        isValid = false;
+        break;
+      }
+      if (!isLoaded)
+      {
+        newTextureIds.push_back(textureId);
+      }
+      pageTextureIds.push_back(textureId);
+    }
+    else if (kind == "sprite")
+    {
+      std::string name;
+      int pageIndex;
+      AtlasSprite sprite;
+      if (!(fields >> name >> pageIndex >> sprite.x >> sprite.y >> sprite.width >> sprite.height) ||
+          pageIndex < 0 || pageIndex >= static_cast<int>(pageTextureIds.size()))
+      {
+        Logger::Errf("Invalid sprite in the atlas %s: %s", listPath, line);
+        isValid = false;
+        break;
+      }
+      sprite.textureId = pageTextureIds[pageIndex];
+      sprites.emplace_back(name, sprite);
+    }
+  }
+
+  if (!isValid)
+  {
+    for (int textureId : newTextureIds)
+    {
+      UnloadTexture(textureId);
+    }
+    return false;
+  }
+  for (const auto &sprite : sprites)
+  {
+    atlasSprites[sprite.first] = sprite.second;
+  }
+
+  Logger::Logf("Atlas %s loaded: %d pages, %d sprites", listPath, static_cast<int>(pageTextureIds.size()), static_cast<int>(sprites.size()));
+  return true;
+}
+
+const AtlasSprite *AssetStore::FindAtlasSprite(const std::string &name) const
+{
+  const auto sprite = atlasSprites.find(name);
+  return sprite != atlasSprites.end() ? &sprite->second : nullptr;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Texture id of the sprites drawn as plain rectangles
+const int NO_TEXTURE = 0;
+
+struct TextureAsset
+{
+  SDL_Texture *texture = nullptr; // nullptr once unloaded
+  int width = 0;
+  int height = 0;
+  std::string path;
+};
+
+// Sub-rectangle of an atlas page holding one of the packed images
+struct AtlasSprite
+{
+  int textureId;
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+// Loads every texture once and hands out small integer ids for them, so that
+// the sprites store an id and rendering finds their texture by indexing a vector.
+// Ids are never reused: a sprite still holding the id of an unloaded texture
+// simply isn't drawn, instead of being drawn with another texture.
+class AssetStore
+{
+private:
+  // Indexed by texture id, NO_TEXTURE being an empty slot
+  std::vector<TextureAsset> textures;
+  // Only used when loading, to give back the id of a texture already loaded
+  std::unordered_map<std::string, int> textureIds;
+  // Sprites of the loaded atlases by image name, only looked up when creating entities
+  std::unordered_map<std::string, AtlasSprite> atlasSprites;
+
+public:
+  AssetStore();
+  ~AssetStore();
+
+  // Unloads every texture and forgets the atlas sprites
+  void ClearAssets();
+
+  // Loads the image at path into a texture and returns its id, or the id it already has if loaded.
+  // Returns NO_TEXTURE if the image couldn't be loaded.
+  int AddTexture(SDL_Renderer *renderer, const std::string &path);
+  void UnloadTexture(int textureId);
+
+  // Loads the pages of an atlas written by tools/AtlasPacker, see Atlas.h, and returns
+  // whether it succeeded. Its sprites can then be found by the name of their image.
+  // On failure nothing of the atlas is kept, the pages it loaded are unloaded again.
+  bool AddAtlas(SDL_Renderer *renderer, const std::string &listPath);
+  // Sprite packed from the image of that name (without extension), nullptr if no atlas has it
+  const AtlasSprite *FindAtlasSprite(const std::string &name) const;
+
+  // Texture of the id, nullptr if unloaded or if it is NO_TEXTURE
+  SDL_Texture *GetTexture(int textureId) const { return textures[textureId].texture; }
+  const TextureAsset &GetTextureAsset(int textureId) const { return textures[textureId]; }
+  // Every texture id given so far is lower than this
+  int GetNumTextureIds() const { return static_cast<int>(textures.size()); }
+};
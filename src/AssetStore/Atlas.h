@@ -0,0 +1,16 @@
+#pragma once
+
+// A texture atlas is built by tools/AtlasPacker (make atlas) out of the images of
+// a directory. It is made of pages, PNG images holding several sprites each, and
+// of a text file listing them, one per line:
+//   page <file name of the page, relative to the list>
+//   sprite <name of the image without extension> <page index> <x> <y> <width> <height>
+
+// Largest size of a page, small enough for any GPU
+const int ATLAS_PAGE_SIZE = 1024;
+
+// Empty pixels kept around each sprite, so that filtering never samples its neighbours
+const int ATLAS_PADDING = 1;
+
+// Where make atlas writes the atlas of assets/images
+const char *const ATLAS_PATH = "./assets/atlas/atlas.txt";
@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CLOCK_USE_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CLOCK_USE_TSC 1
+#endif
+
+// Clock the profiler zones and the log records are stamped with: the time stamp
+// counter of the CPU on x86, which costs less than half of a steady clock reading,
+// and steady clock nanoseconds elsewhere.
+// The length of a tick is measured against the steady clock, from a single
+// calibration point shared by every user of the clock.
+class Clock
+{
+private:
+  struct Calibration
+  {
+    int64_t ticks;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  // Taken on the first call, the function being inline there is one for the whole program
+  static const Calibration &GetCalibration()
+  {
+    static const Calibration calibration = {Now(), std::chrono::steady_clock::now()};
+    return calibration;
+  }
+
+public:
+  static int64_t Now()
+  {
+#ifdef CLOCK_USE_TSC
+    return static_cast<int64_t>(__rdtsc());
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // Starts measuring the length of a tick, the earlier the more precise
+  static void Calibrate() { GetCalibration(); }
+
+  static double GetNanosecondsPerTick()
+  {
+#ifdef CLOCK_USE_TSC
+    const Calibration &calibration = GetCalibration();
+    const int64_t ticks = Now() - calibration.ticks;
+    const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - calibration.time).count();
+    return ticks > 0 ? nanoseconds / ticks : 1.0;
+#else
+    return 1.0;
+#endif
+  }
+};
@@ -5,10 +5,18 @@ struct SpriteComponent
 {
   int width;
   int height;
+  // Id given by the AssetStore, 0 (NO_TEXTURE) draws a plain rectangle
+  int textureId;
+  // Top-left corner of the sprite inside its texture, the source rectangle being width x height
+  int srcX;
+  int srcY;
 
-  SpriteComponent(int width = 0, int height = 0)
+  SpriteComponent(int width = 0, int height = 0, int textureId = 0, int srcX = 0, int srcY = 0)
   {
     this->width = width;
     this->height = height;
+    this->textureId = textureId;
+    this->srcX = srcX;
+    this->srcY = srcY;
   }
-};
\ No newline at end of file
+};
@@ -4,12 +4,16 @@
 struct TransformComponent
 {
   glm::vec2 position;
+  // Position at the previous simulation step, the renderer interpolates between the two.
+  // Set it along with the position to move an entity without interpolation, e.g. teleporting.
+  glm::vec2 previousPosition;
   glm::vec2 scale;
   double rotation;
 
   TransformComponent(glm::vec2 position = glm::vec2(0, 0), glm::vec2 scale = glm::vec2(1, 1), double rotation = 0.0f)
   {
     this->position = position;
+    this->previousPosition = position;
     this->scale = scale;
     this->rotation = rotation;
   }
@@ -1,4 +1,11 @@
 #include "ECS.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <new>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
 
 int IComponent::nextId = 0;
 
@@ -8,7 +15,17 @@ int IComponent::nextId = 0;
 
 int Entity::GetId() const
 {
-  return id;
+  return handle & ENTITY_ID_MASK;
+}
+
+int Entity::GetGeneration() const
+{
+  return (handle >> ENTITY_ID_BITS) & ENTITY_GENERATION_MASK;
+}
+
+void Entity::Kill()
+{
+  registry->KillEntity(*this);
 }
 
 ///////////////////////////////////
@@ -17,22 +34,45 @@ int Entity::GetId() const
 
 void System::AddEntityToSytem(Entity entity)
 {
+  const auto entityId = entity.GetId();
+  if (entityId >= static_cast<int>(entityIdToSlot.size()))
+  {
+    entityIdToSlot.resize(entityId + 1, -1);
+  }
+  else if (entityIdToSlot[entityId] != -1)
+  {
+    return;
+  }
+
+  entityIdToSlot[entityId] = entities.size();
   entities.push_back(entity);
 }
 
 void System::RemoveEntityFromSystem(Entity entity)
 {
-  for (int i = 0; i < entities.size(); i++)
+  if (!HasEntity(entity))
   {
-    if (entities.at(i) == entity)
-    {
-      entities.pop_back();
-      return;
-    }
+    return;
   }
+
+  // Swap the last entity into the freed slot so the removal is O(1)
+  const auto entityId = entity.GetId();
+  const int slot = entityIdToSlot[entityId];
+  const Entity last = entities.back();
+  entities[slot] = last;
+  entityIdToSlot[last.GetId()] = slot;
+
+  entities.pop_back();
+  entityIdToSlot[entityId] = -1;
 }
 
-std::vector<Entity> System::GetSystemEntities() const
+bool System::HasEntity(Entity entity) const
+{
+  const auto entityId = entity.GetId();
+  return entityId < static_cast<int>(entityIdToSlot.size()) && entityIdToSlot[entityId] != -1;
+}
+
+const std::vector<Entity> &System::GetSystemEntities() const
 {
   return entities;
 }
@@ -42,48 +82,547 @@ const Signature &System::GetComponentSignature() const
   return componentSignature;
 }
 
+//////////////////////////////////////
+// Archetype methods implementation //
+//////////////////////////////////////
+
+// Chunks are aligned on a cache line
+const size_t CHUNK_ALIGNMENT = 64;
+
+static size_t AlignUp(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+Archetype::Archetype(const Signature &signature, const std::vector<ComponentInfo> &registeredComponents)
+    : signature(signature)
+{
+  std::fill(std::begin(columnOffsets), std::end(columnOffsets), -1);
+  std::fill(std::begin(componentSizes), std::end(componentSizes), 0);
+
+  size_t rowBytes = sizeof(int);
+  for (int componentId = 0; componentId < static_cast<int>(MAX_COMPONENTS); componentId++)
+  {
+    if (signature.test(componentId))
+    {
+      componentIds.push_back(componentId);
+      componentInfos.push_back(registeredComponents[componentId]);
+      componentSizes[componentId] = registeredComponents[componentId].size;
+      rowBytes += registeredComponents[componentId].size;
+    }
+  }
+
+  // Chunk layout: the entity id column first, then one column per component
+  auto layout = [this](int capacity)
+  {
+    size_t offset = sizeof(int) * capacity;
+    for (size_t i = 0; i < componentIds.size(); i++)
+    {
+      offset = AlignUp(offset, componentInfos[i].alignment);
+      columnOffsets[componentIds[i]] = offset;
+      offset += componentInfos[i].size * capacity;
+    }
+    return offset;
+  };
+
+  // Fit as many entities as possible in a chunk, accounting for the column padding
+  chunkCapacity = std::max<int>(1, ARCHETYPE_CHUNK_SIZE / rowBytes);
+  while (chunkCapacity > 1 && layout(chunkCapacity) > ARCHETYPE_CHUNK_SIZE)
+  {
+    chunkCapacity--;
+  }
+  chunkBytes = std::max(ARCHETYPE_CHUNK_SIZE, layout(chunkCapacity));
+}
+
+Archetype::~Archetype()
+{
+  for (int row = 0; row < numEntities; row++)
+  {
+    for (size_t i = 0; i < componentIds.size(); i++)
+    {
+      componentInfos[i].destroy(GetAddress(componentIds[i], row));
+    }
+  }
+
+  for (auto chunk : chunks)
+  {
+    ::operator delete(chunk, std::align_val_t(CHUNK_ALIGNMENT));
+  }
+}
+
+unsigned char *Archetype::GetAddress(int componentId, int row) const
+{
+  const int chunkIndex = row / chunkCapacity;
+  const int rowInChunk = row % chunkCapacity;
+  return chunks[chunkIndex] + columnOffsets[componentId] + rowInChunk * componentSizes[componentId];
+}
+
+int Archetype::GetChunkSize(int chunkIndex) const
+{
+  return std::min(chunkCapacity, numEntities - chunkIndex * chunkCapacity);
+}
+
+void Archetype::Reserve(int capacity)
+{
+  while (static_cast<int>(chunks.size()) * chunkCapacity < capacity)
+  {
+    chunks.push_back(static_cast<unsigned char *>(::operator new(chunkBytes, std::align_val_t(CHUNK_ALIGNMENT))));
+  }
+}
+
+int Archetype::AddEntity(int entityId)
+{
+  if (numEntities == static_cast<int>(chunks.size()) * chunkCapacity)
+  {
+    chunks.push_back(static_cast<unsigned char *>(::operator new(chunkBytes, std::align_val_t(CHUNK_ALIGNMENT))));
+  }
+
+  const int row = numEntities++;
+  const_cast<int *>(GetEntityIds(row / chunkCapacity))[row % chunkCapacity] = entityId;
+  return row;
+}
+
+int Archetype::RemoveEntity(int row)
+{
+  const int lastRow = numEntities - 1;
+  const int movedEntityId = (row != lastRow) ? GetEntityIds(lastRow / chunkCapacity)[lastRow % chunkCapacity] : -1;
+
+  // Keep the chunks packed by moving the last row into the hole
+  for (size_t i = 0; i < componentIds.size(); i++)
+  {
+    void *component = GetAddress(componentIds[i], row);
+    componentInfos[i].destroy(component);
+    if (row != lastRow)
+    {
+      void *lastComponent = GetAddress(componentIds[i], lastRow);
+      componentInfos[i].moveConstruct(component, lastComponent);
+      componentInfos[i].destroy(lastComponent);
+    }
+  }
+
+  if (movedEntityId != -1)
+  {
+    const_cast<int *>(GetEntityIds(row / chunkCapacity))[row % chunkCapacity] = movedEntityId;
+  }
+  numEntities--;
+
+  // Release the trailing chunks we no longer need, keeping one spare to avoid
+  // reallocating when an entity goes back and forth across a chunk boundary
+  const int chunksInUse = (numEntities + chunkCapacity - 1) / chunkCapacity;
+  while (static_cast<int>(chunks.size()) > chunksInUse + 1)
+  {
+    ::operator delete(chunks.back(), std::align_val_t(CHUNK_ALIGNMENT));
+    chunks.pop_back();
+  }
+
+  return movedEntityId;
+}
+
+//////////////////////////////////////////
+// CommandBuffer methods implementation //
+//////////////////////////////////////////
+
+CommandBuffer::~CommandBuffer()
+{
+  Clear();
+  for (auto block : arenaBlocks)
+  {
+    ::operator delete(block, std::align_val_t(CHUNK_ALIGNMENT));
+  }
+}
+
+void *CommandBuffer::Allocate(size_t size, size_t alignment)
+{
+  // Bump allocate in the current block, moving on to the next one when it is full
+  while (currentBlock < arenaBlocks.size())
+  {
+    const size_t offset = AlignUp(currentOffset, alignment);
+    if (offset + size <= arenaBlockSizes[currentBlock])
+    {
+      currentOffset = offset + size;
+      return arenaBlocks[currentBlock] + offset;
+    }
+    currentBlock++;
+    currentOffset = 0;
+  }
+
+  // Every block is full, add a new one big enough for the data
+  const size_t blockSize = std::max(COMMAND_ARENA_BLOCK_SIZE, size);
+  arenaBlocks.push_back(static_cast<unsigned char *>(::operator new(blockSize, std::align_val_t(CHUNK_ALIGNMENT))));
+  arenaBlockSizes.push_back(blockSize);
+  currentBlock = arenaBlocks.size() - 1;
+  currentOffset = size;
+  return arenaBlocks.back();
+}
+
+Entity CommandBuffer::CreateEntity()
+{
+  return registry->CreateEntity();
+}
+
+void CommandBuffer::KillEntity(Entity entity)
+{
+  commands.push_back({CommandType::KillEntity, entity, nullptr, nullptr, nullptr});
+}
+
+void CommandBuffer::Playback(std::vector<Entity> &createdEntities, std::vector<Entity> &killedEntities)
+{
+  for (auto &command : commands)
+  {
+    switch (command.type)
+    {
+    case CommandType::CreateEntity:
+      createdEntities.push_back(command.entity);
+      break;
+    case CommandType::KillEntity:
+      killedEntities.push_back(command.entity);
+      break;
+    case CommandType::ChangeComponent:
+      // The entity may have been killed before the command was recorded
+      if (registry->IsAlive(command.entity))
+      {
+        command.apply(*registry, command.entity, command.payload);
+      }
+      else if (command.discard)
+      {
+        command.discard(command.payload);
+      }
+      command.discard = nullptr;
+      break;
+    }
+  }
+}
+
+void CommandBuffer::Clear()
+{
+  // Destroy the recorded components that were never applied
+  for (auto &command : commands)
+  {
+    if (command.discard)
+    {
+      command.discard(command.payload);
+    }
+  }
+  commands.clear();
+
+  // Keep the arena blocks around for the next frame
+  currentBlock = 0;
+  currentOffset = 0;
+}
+
 /////////////////////////////////////
 // Registry methods implementation //
 /////////////////////////////////////
 
-Entity Registry::CreateEntity()
+Entity Registry::NewEntity()
 {
   int entityId;
-  entityId = numEntities++;
 
-  Entity entity(entityId);
-  entity.registry = this;
-  entitiesToBeAdded.insert(entity);
+  if (freeIds.empty())
+  {
+    // No ids to reuse, expand the registry
+    entityId = numEntities++;
+    assert(entityId <= static_cast<int>(ENTITY_ID_MASK) && "Too many entities for the entity id bits");
 
-  if (entityId >= entityComponentSignatures.size())
+    if (entityId >= static_cast<int>(entityComponentSignatures.size()))
+    {
+      entityComponentSignatures.resize(entityId + 1);
+      entityGenerations.resize(entityId + 1, 0);
+      entityIsAwaitingSystems.resize(entityId + 1, false);
+      if (storageMode == StorageMode::Archetype)
+      {
+        entityLocations.resize(entityId + 1);
+      }
+    }
+  }
+  else
   {
-    entityComponentSignatures.resize(entityId + 1);
+    // Reuse the id of a previously killed entity
+    entityId = freeIds.front();
+    freeIds.pop_front();
   }
 
-  Logger::Log("Entity created with id: " + std::to_string(entityId));
+  Entity entity(entityId, entityGenerations[entityId]);
+  entity.registry = this;
+  commandBuffer.commands.push_back({CommandBuffer::CommandType::CreateEntity, entity, nullptr, nullptr, nullptr});
+  entityIsAwaitingSystems[entityId] = true;
+  numEntitiesAwaitingSystems++;
 
   return entity;
 }
 
-void Registry::AddEntityToSystems(Entity entity)
+Entity Registry::CreateEntity()
+{
+  Entity entity = NewEntity();
+
+  LOG_TRACE(ECS, "Entity created with id: %d", entity.GetId());
+
+  return entity;
+}
+
+void Registry::Reserve(int entityCount)
+{
+  entityComponentSignatures.reserve(entityCount);
+  entityGenerations.reserve(entityCount);
+  entityIsAwaitingSystems.reserve(entityCount);
+  if (storageMode == StorageMode::Archetype)
+  {
+    entityLocations.reserve(entityCount);
+  }
+
+  for (auto &pool : componentPools)
+  {
+    if (pool)
+    {
+      pool->ReserveEntityIds(entityCount);
+    }
+  }
+
+  // Every entity created before the next update records a command
+  const int numNewEntities = std::max(0, entityCount - GetNumEntities());
+  commandBuffer.commands.reserve(commandBuffer.commands.size() + numNewEntities);
+}
+
+void Registry::KillEntity(Entity entity)
+{
+  commandBuffer.KillEntity(entity);
+}
+
+bool Registry::IsAlive(Entity entity) const
 {
   const auto entityId = entity.GetId();
-  const auto &entityComponentSignature = entityComponentSignatures[entityId];
+  return entityId < static_cast<int>(entityGenerations.size()) && entityGenerations[entityId] == entity.GetGeneration();
+}
+
+// Readable name of a type from its typeid name
+static std::string DemangleTypeName(const char *name)
+{
+#ifdef __GNUG__
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled)
+  {
+    std::string readable = demangled;
+    std::free(demangled);
+    return readable;
+  }
+#endif
+  return name;
+}
+
+std::vector<ComponentStats> Registry::GetComponentStats() const
+{
+  std::vector<ComponentStats> stats;
+  for (int componentId = 0; componentId < static_cast<int>(componentInfos.size()); componentId++)
+  {
+    const ComponentInfo &info = componentInfos[componentId];
+    if (!info.name)
+    {
+      continue;
+    }
+
+    ComponentStats componentStats{componentId, DemangleTypeName(info.name), 0, 0};
+    if (storageMode == StorageMode::Archetype)
+    {
+      // Every chunk of an archetype holds a full column for each of its components
+      for (const auto &[signature, archetype] : archetypes)
+      {
+        if (signature.test(componentId))
+        {
+          componentStats.numComponents += archetype->GetNumEntities();
+          componentStats.memoryUsage += archetype->GetNumChunks() * archetype->GetChunkCapacity() * info.size;
+        }
+      }
+    }
+    else if (componentId < static_cast<int>(componentPools.size()) && componentPools[componentId])
+    {
+      componentStats.numComponents = componentPools[componentId]->GetSize();
+      componentStats.memoryUsage = componentPools[componentId]->GetMemoryUsage();
+    }
+    stats.push_back(componentStats);
+  }
+  return stats;
+}
+
+Archetype *Registry::GetOrCreateArchetype(const Signature &signature)
+{
+  auto archetype = archetypes.find(signature);
+  if (archetype != archetypes.end())
+  {
+    return archetype->second.get();
+  }
+
+  auto newArchetype = std::make_unique<Archetype>(signature, componentInfos);
+  Archetype *result = newArchetype.get();
+  archetypes.emplace(signature, std::move(newArchetype));
+  return result;
+}
+
+void Registry::MoveEntityToArchetype(int entityId, const Signature &newSignature)
+{
+  Archetype *source = entityLocations[entityId].archetype;
+  const int sourceRow = entityLocations[entityId].row;
+
+  // An entity without any component doesn't live in any archetype
+  Archetype *destination = newSignature.none() ? nullptr : GetOrCreateArchetype(newSignature);
+  int destinationRow = -1;
+
+  if (destination)
+  {
+    destinationRow = destination->AddEntity(entityId);
+
+    // Carry over the components that both archetypes have in common
+    if (source)
+    {
+      for (auto componentId : source->GetComponentIds())
+      {
+        if (newSignature.test(componentId))
+        {
+          componentInfos[componentId].moveConstruct(
+              destination->GetComponent(componentId, destinationRow),
+              source->GetComponent(componentId, sourceRow));
+        }
+      }
+    }
+  }
+
+  if (source)
+  {
+    // Destroys what is left in the old row and fills it with the last entity of the archetype
+    const int movedEntityId = source->RemoveEntity(sourceRow);
+    if (movedEntityId != -1)
+    {
+      entityLocations[movedEntityId].row = sourceRow;
+    }
+  }
+
+  entityLocations[entityId].archetype = destination;
+  entityLocations[entityId].row = destinationRow;
+}
+
+void Registry::IndexSystems()
+{
+  componentSystems.assign(MAX_COMPONENTS, std::vector<System *>());
+  systemsWithoutComponents.clear();
 
   for (auto &system : systems)
   {
     const auto &systemComponentSignature = system.second->GetComponentSignature();
-    bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+    if (systemComponentSignature.none())
+    {
+      systemsWithoutComponents.push_back(system.second.get());
+    }
+
+    for (size_t componentId = 0; componentId < MAX_COMPONENTS; componentId++)
+    {
+      if (systemComponentSignature.test(componentId))
+      {
+        componentSystems[componentId].push_back(system.second.get());
+      }
+    }
+  }
+}
+
+void Registry::AddEntityToSystems(Entity entity)
+{
+  const auto entityId = entity.GetId();
+  const auto &entityComponentSignature = entityComponentSignatures[entityId];
+
+  if (entityIsAwaitingSystems[entityId])
+  {
+    entityIsAwaitingSystems[entityId] = false;
+    numEntitiesAwaitingSystems--;
+  }
+
+  for (auto system : systemsWithoutComponents)
+  {
+    system->AddEntityToSytem(entity);
+  }
+
+  // Only the systems requiring one of the entity's components can be interested in it
+  for (size_t componentId = 0; componentId < componentSystems.size(); componentId++)
+  {
+    if (!entityComponentSignature.test(componentId))
+    {
+      continue;
+    }
+
+    for (auto system : componentSystems[componentId])
+    {
+      const auto &systemComponentSignature = system->GetComponentSignature();
+      bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+
+      if (isInterested)
+      {
+        system->AddEntityToSytem(entity);
+      }
+    }
+  }
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity)
+{
+  const auto &entityComponentSignature = entityComponentSignatures[entity.GetId()];
+
+  for (auto system : systemsWithoutComponents)
+  {
+    system->RemoveEntityFromSystem(entity);
+  }
+
+  for (size_t componentId = 0; componentId < componentSystems.size(); componentId++)
+  {
+    if (entityComponentSignature.test(componentId))
+    {
+      for (auto system : componentSystems[componentId])
+      {
+        system->RemoveEntityFromSystem(entity);
+      }
+    }
+  }
+}
+
+void Registry::OnComponentAdded(Entity entity, int componentId)
+{
+  // New entities join their systems all at once in the next Registry::Update
+  if (entityIsAwaitingSystems[entity.GetId()] || componentSystems.empty())
+  {
+    return;
+  }
 
-    if (isInterested)
+  const auto &entityComponentSignature = entityComponentSignatures[entity.GetId()];
+  for (auto system : componentSystems[componentId])
+  {
+    const auto &systemComponentSignature = system->GetComponentSignature();
+    if ((entityComponentSignature & systemComponentSignature) == systemComponentSignature)
     {
-      system.second->AddEntityToSytem(entity);
+      system->AddEntityToSytem(entity);
     }
   }
 }
 
+void Registry::OnComponentRemoved(Entity entity, int componentId)
+{
+  if (entityIsAwaitingSystems[entity.GetId()] || componentSystems.empty())
+  {
+    return;
+  }
+
+  // The systems requiring this component are no longer interested in the entity
+  for (auto system : componentSystems[componentId])
+  {
+    system->RemoveEntityFromSystem(entity);
+  }
+}
+
 void Registry::Update()
 {
+  PROFILE_ZONE("Registry::Update");
+
+  // Apply the component changes recorded since the last update,
+  // and gather the entities that were created and killed meanwhile
+  commandBuffer.Playback(entitiesToBeAdded, entitiesToBeKilled);
+  commandBuffer.Clear();
+
   // Add the entities that are waiting to be created to the active systems
   for (auto entity : entitiesToBeAdded)
   {
@@ -91,5 +630,44 @@ void Registry::Update()
   }
   entitiesToBeAdded.clear();
 
+  // Sort once so the entities killed several times are processed only once
+  std::sort(entitiesToBeKilled.begin(), entitiesToBeKilled.end());
+  entitiesToBeKilled.erase(std::unique(entitiesToBeKilled.begin(), entitiesToBeKilled.end()), entitiesToBeKilled.end());
+
   // Remove the entities that are waiting to be killed from the active systems
+  for (auto entity : entitiesToBeKilled)
+  {
+    // Skip the handles of entities that were already killed
+    if (!IsAlive(entity))
+    {
+      continue;
+    }
+
+    const auto entityId = entity.GetId();
+    RemoveEntityFromSystems(entity);
+
+    // Release the components of the entity
+    if (storageMode == StorageMode::Archetype)
+    {
+      MoveEntityToArchetype(entityId, Signature());
+    }
+    else
+    {
+      for (size_t componentId = 0; componentId < componentPools.size(); componentId++)
+      {
+        if (entityComponentSignatures[entityId].test(componentId))
+        {
+          componentPools[componentId]->RemoveEntityFromPool(entityId);
+        }
+      }
+    }
+    entityComponentSignatures[entityId].reset();
+
+    // Invalidate the handles to the entity and make its id available again
+    entityGenerations[entityId] = (entityGenerations[entityId] + 1) & ENTITY_GENERATION_MASK;
+    freeIds.push_back(entityId);
+
+    LOG_TRACE(ECS, "Entity killed with id: %d", entityId);
+  }
+  entitiesToBeKilled.clear();
 }
\ No newline at end of file
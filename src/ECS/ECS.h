@@ -3,7 +3,13 @@
 #include <vector>
 #include <unordered_map>
 #include <typeindex>
-#include <set>
+#include <typeinfo>
+#include <string>
+#include <memory>
+#include <tuple>
+#include <deque>
+#include <cassert>
+#include <cstdlib>
 #include "../Logger/Logger.h"
 
 const unsigned int MAX_COMPONENTS = 32;
@@ -40,22 +46,32 @@ public:
 // Entity class declaration //
 //////////////////////////////
 
+// An entity handle packs the entity id (index in the registry) in its low bits
+// and a generation counter in its high bits. Ids are recycled once an entity
+// is killed, and the generation is bumped so stale handles can be detected.
+const unsigned int ENTITY_ID_BITS = 24;
+const unsigned int ENTITY_GENERATION_BITS = 8;
+const unsigned int ENTITY_ID_MASK = (1u << ENTITY_ID_BITS) - 1;
+const unsigned int ENTITY_GENERATION_MASK = (1u << ENTITY_GENERATION_BITS) - 1;
+
 class Entity
 {
 private:
-  int id;
+  unsigned int handle;
 
 public:
-  Entity(int id) : id(id){}; // id(id) to initialize id automatically
+  Entity(int id, int generation = 0) : handle((static_cast<unsigned int>(generation) << ENTITY_ID_BITS) | id){};
   Entity(const Entity &entity) = default;
   int GetId() const;
+  int GetGeneration() const;
+  void Kill();
 
   // operator overloading to compare 2 entities easily
   Entity &operator=(const Entity &other) = default;
-  bool operator==(const Entity &other) const { return id == other.id; }
-  bool operator!=(const Entity &other) const { return id != other.id; }
-  bool operator>(const Entity &other) const { return id > other.id; }
-  bool operator<(const Entity &other) const { return id < other.id; }
+  bool operator==(const Entity &other) const { return handle == other.handle; }
+  bool operator!=(const Entity &other) const { return handle != other.handle; }
+  bool operator>(const Entity &other) const { return handle > other.handle; }
+  bool operator<(const Entity &other) const { return handle < other.handle; }
 
   template <typename TComponent, typename... TArgs>
   void AddComponent(TArgs &&...args);
@@ -77,6 +93,9 @@ public:
 // System class declaration //
 //////////////////////////////
 
+template <typename... TComponents>
+class ComponentView;
+
 // The system processes entities that contain a specific signature
 class System
 {
@@ -84,14 +103,29 @@ private:
   Signature componentSignature;
   std::vector<Entity> entities;
 
+  // Position of each entity in the entities vector, or -1 if the system doesn't have it
+  // [index = entity id]
+  std::vector<int> entityIdToSlot;
+
+  // Registry owning the system, set when the system is added to it
+  class Registry *registry = nullptr;
+  friend class Registry;
+
 public:
   System() = default;
   ~System() = default;
 
   void AddEntityToSytem(Entity entity);
   void RemoveEntityFromSystem(Entity entity);
-  std::vector<Entity> GetSystemEntities() const;
+  bool HasEntity(Entity entity) const;
+  const std::vector<Entity> &GetSystemEntities() const;
   const Signature &GetComponentSignature() const;
+  Registry &GetRegistry() const { return *registry; }
+
+  // Iterates the entities of the system along with references to their components,
+  // e.g. for (auto [entity, transform, sprite] : View<TransformComponent, SpriteComponent>())
+  template <typename... TComponents>
+  ComponentView<TComponents...> View() const;
 
   // Defines the component type that entities must have to be considered by the system
   template <typename TComponent>
@@ -102,48 +136,366 @@ public:
 // Registry class declaration //
 ////////////////////////////////
 
-// A pool is a vector of objects of type T
+// A pool is a sparse set of objects of type T:
+// the components are packed contiguously in a dense vector, and a sparse
+// vector maps each entity id to the slot holding its component.
+// Iterating a pool only touches live components, and its memory grows with
+// the number of components rather than with the highest entity id.
 class IPool
 {
 public:
   virtual ~IPool() {}
+  virtual void RemoveEntityFromPool(int entityId) = 0;
+  virtual void ReserveEntityIds(int numEntityIds) = 0;
+  virtual int GetSize() const = 0;
+  // Bytes allocated by the pool
+  virtual size_t GetMemoryUsage() const = 0;
 };
 
 template <typename T>
 class Pool : public IPool
 {
 private:
+  // Packed component data
+  // [index = dense index]
   std::vector<T> data;
 
+  // Entity that owns each packed component
+  // [index = dense index]
+  std::vector<int> indexToEntityId;
+
+  // Slot of the entity's component in data, or -1 if it has none
+  // [index = entity id]
+  std::vector<int> entityIdToIndex;
+
 public:
-  Pool(int size = 100)
+  Pool(int capacity = 100)
   {
-    data.resize(size);
+    data.reserve(capacity);
+    indexToEntityId.reserve(capacity);
   }
   virtual ~Pool() = default;
 
   bool isEmpty() const { return data.empty(); }
-  int GetSize() const { return data.size(); }
-  void Resize(int newSize) { data.resize(newSize); }
-  void Clear() { data.clear(); }
-  void Add(T object) { data.push_back(object); }
-  void Set(int index, T object) { data[index] = object; }
-  T &Get(int index) { return static_cast<T &>(data[index]); }
-  T &operator[](unsigned int index) const { return data[index]; };
+  int GetSize() const override { return data.size(); }
+
+  size_t GetMemoryUsage() const override
+  {
+    return data.capacity() * sizeof(T) + (indexToEntityId.capacity() + entityIdToIndex.capacity()) * sizeof(int);
+  }
+
+  // Grow the packed data once for the given number of components
+  void Reserve(int capacity)
+  {
+    data.reserve(capacity);
+    indexToEntityId.reserve(capacity);
+  }
+
+  // Grow the sparse entity id -> slot map once for the given number of entity ids
+  void ReserveEntityIds(int numEntityIds) override
+  {
+    if (numEntityIds > static_cast<int>(entityIdToIndex.size()))
+    {
+      entityIdToIndex.resize(numEntityIds, -1);
+    }
+  }
+
+  void Clear()
+  {
+    data.clear();
+    indexToEntityId.clear();
+    entityIdToIndex.clear();
+  }
+
+  bool Contains(int entityId) const
+  {
+    return entityId < static_cast<int>(entityIdToIndex.size()) && entityIdToIndex[entityId] != -1;
+  }
+
+  // Constructs the component of the entity directly in the packed data,
+  // or replaces the existing one by moving a newly constructed component into it
+  template <typename... TArgs>
+  T &Emplace(int entityId, TArgs &&...args)
+  {
+    if (Contains(entityId))
+    {
+      T &component = data[entityIdToIndex[entityId]];
+      component = T(std::forward<TArgs>(args)...);
+      return component;
+    }
+
+    if (entityId >= static_cast<int>(entityIdToIndex.size()))
+    {
+      entityIdToIndex.resize(entityId + 1, -1);
+    }
+
+    entityIdToIndex[entityId] = data.size();
+    indexToEntityId.push_back(entityId);
+    return data.emplace_back(std::forward<TArgs>(args)...);
+  }
+
+  void Set(int entityId, T object) { Emplace(entityId, std::move(object)); }
+
+  void Remove(int entityId)
+  {
+    if (!Contains(entityId))
+    {
+      return;
+    }
+
+    // Keep the data packed by moving the last component into the freed slot
+    const int indexOfRemoved = entityIdToIndex[entityId];
+    const int indexOfLast = data.size() - 1;
+    if (indexOfRemoved != indexOfLast)
+    {
+      const int entityIdOfLast = indexToEntityId[indexOfLast];
+      data[indexOfRemoved] = std::move(data[indexOfLast]);
+      indexToEntityId[indexOfRemoved] = entityIdOfLast;
+      entityIdToIndex[entityIdOfLast] = indexOfRemoved;
+    }
+
+    entityIdToIndex[entityId] = -1;
+    data.pop_back();
+    indexToEntityId.pop_back();
+  }
+
+  void RemoveEntityFromPool(int entityId) override { Remove(entityId); }
+
+  T &Get(int entityId) { return data[entityIdToIndex[entityId]]; }
+  const std::vector<int> &GetEntityIds() const { return indexToEntityId; }
+
+  // Direct access to the packed data, for linear iteration over the pool
+  T &operator[](unsigned int index) { return data[index]; }
+  int GetEntityId(unsigned int index) const { return indexToEntityId[index]; }
+};
+
+/////////////////////////////////
+// Archetype class declaration //
+/////////////////////////////////
+
+// Size of the memory blocks holding the entities of an archetype
+const size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+
+// Type-erased description of a component type, so that archetypes can move
+// and destroy component data without knowing its C++ type
+struct ComponentInfo
+{
+  // Mangled on some compilers, see Registry::GetComponentStats
+  const char *name = nullptr;
+  size_t size = 0;
+  size_t alignment = 0;
+  void (*moveConstruct)(void *destination, void *source) = nullptr;
+  void (*destroy)(void *component) = nullptr;
+
+  template <typename TComponent>
+  static ComponentInfo Create();
+};
+
+// An archetype stores every entity sharing the exact same signature.
+// Entities are packed into fixed-size chunks, and each chunk holds one
+// contiguous column per component type (SoA), so iterating several components
+// of many entities streams linearly through memory.
+class Archetype
+{
+private:
+  Signature signature;
+
+  // Components stored by the archetype, sorted by id
+  std::vector<int> componentIds;
+  std::vector<ComponentInfo> componentInfos;
+
+  // Byte offset of each component column inside a chunk, or -1 if absent
+  // [index = component id]
+  int columnOffsets[MAX_COMPONENTS];
+  size_t componentSizes[MAX_COMPONENTS];
+
+  // Number of entities fitting in one chunk, and the size of a chunk in bytes
+  int chunkCapacity;
+  size_t chunkBytes;
+
+  // Every chunk is full except the last one
+  std::vector<unsigned char *> chunks;
+  int numEntities = 0;
+
+  unsigned char *GetAddress(int componentId, int row) const;
+
+public:
+  Archetype(const Signature &signature, const std::vector<ComponentInfo> &registeredComponents);
+  ~Archetype();
+  Archetype(const Archetype &) = delete;
+  Archetype &operator=(const Archetype &) = delete;
+
+  const Signature &GetSignature() const { return signature; }
+  const std::vector<int> &GetComponentIds() const { return componentIds; }
+  int GetNumEntities() const { return numEntities; }
+  int GetChunkCapacity() const { return chunkCapacity; }
+  int GetNumChunks() const { return chunks.size(); }
+  int GetChunkSize(int chunkIndex) const;
+
+  // Allocates the chunks needed to hold the given number of entities
+  void Reserve(int capacity);
+
+  // Reserves a row for the entity and returns it, the components are left uninitialized
+  int AddEntity(int entityId);
+
+  // Destroys the components of a row and fills the hole with the last row,
+  // returns the id of the entity that was moved into the row or -1 if none
+  int RemoveEntity(int row);
+
+  void *GetComponent(int componentId, int row) const { return GetAddress(componentId, row); }
+  void *GetColumn(int componentId, int chunkIndex) const { return chunks[chunkIndex] + columnOffsets[componentId]; }
+  const int *GetEntityIds(int chunkIndex) const { return reinterpret_cast<const int *>(chunks[chunkIndex]); }
+};
+
+typedef std::unordered_map<Signature, std::unique_ptr<Archetype>> ArchetypeMap;
+
+/////////////////////////////////////
+// CommandBuffer class declaration //
+/////////////////////////////////////
+
+// Size of the arena blocks holding the recorded component data
+const size_t COMMAND_ARENA_BLOCK_SIZE = 64 * 1024;
+
+// A command buffer records structural changes (entity creation and destruction,
+// component addition and removal) and plays them back in one batched pass
+// during Registry::Update. Systems can fill it while iterating over a view,
+// since nothing moves until the playback.
+// Commands and component data live in linear storage that is reused from one
+// frame to the next, so recording doesn't allocate once it has warmed up.
+class CommandBuffer
+{
+private:
+  enum class CommandType
+  {
+    CreateEntity,
+    KillEntity,
+    ChangeComponent
+  };
+
+  struct Command
+  {
+    CommandType type;
+    Entity entity;
+
+    // Component changes: applies the change to the registry, using the recorded component data if any
+    void (*apply)(Registry &registry, Entity entity, void *payload);
+    // Destroys the recorded component data if the command is never applied
+    void (*discard)(void *payload);
+    void *payload;
+  };
+
+  Registry *registry;
+  std::vector<Command> commands;
+
+  // Arena blocks holding the recorded components, they never move so the payloads stay valid
+  std::vector<unsigned char *> arenaBlocks;
+  std::vector<size_t> arenaBlockSizes;
+  size_t currentBlock = 0;
+  size_t currentOffset = 0;
+
+  void *Allocate(size_t size, size_t alignment);
+
+public:
+  CommandBuffer(Registry *registry) : registry(registry) {}
+  ~CommandBuffer();
+  CommandBuffer(const CommandBuffer &) = delete;
+  CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+  bool IsEmpty() const { return commands.empty(); }
+
+  // The id of the new entity is reserved immediately, the entity joins the systems on playback
+  Entity CreateEntity();
+  void KillEntity(Entity entity);
+
+  template <typename TComponent, typename... TArgs>
+  void AddComponent(Entity entity, TArgs &&...args);
+  template <typename TComponent>
+  void RemoveComponent(Entity entity);
+
+  // Applies the component changes in the order they were recorded, and hands
+  // out the entities that were created and killed
+  void Playback(std::vector<Entity> &createdEntities, std::vector<Entity> &killedEntities);
+  void Clear();
+
+  friend class Registry;
+};
+
+// Number of components of one type and the memory holding them, for the debug tools
+struct ComponentStats
+{
+  int componentId;
+  std::string name;
+  int numComponents;
+  size_t memoryUsage;
+};
+
+// Component storage strategies supported by the registry:
+// - SparseSet: one packed pool per component type, cheap structural changes
+// - Archetype: entities grouped by signature in chunks of SoA columns,
+//   faster iteration over several components at once
+enum class StorageMode
+{
+  SparseSet,
+  Archetype
 };
 
 // The registry manages the creation and destruction of entities, add systems, and components
 class Registry
 {
 private:
-  // Keep track of how many entities were added to the scene
+  // Keep track of how many entity ids were handed out, including the recycled ones
   int numEntities = 0;
 
+  // Ids of the killed entities, available to be reused
+  std::deque<int> freeIds;
+
+  // Generation of the entity currently using each id
+  // [index = entity id]
+  std::vector<unsigned char> entityGenerations;
+
   // Each pool contains all the data for a certain component type
   // [Vector index = component type id]
-  // [Pool index = entity id]
+  // [Pool = sparse set keyed by entity id]
   std::vector<std::shared_ptr<IPool>> componentPools;
 
+  // How the component data is stored, chosen when the registry is created
+  StorageMode storageMode;
+
+  // Archetype storage: the archetype holding an entity and its row inside it
+  struct EntityLocation
+  {
+    Archetype *archetype = nullptr;
+    int row = -1;
+  };
+
+  // Type-erased operations of each component type
+  // [index = component type id]
+  std::vector<ComponentInfo> componentInfos;
+
+  // One archetype per distinct signature in use
+  ArchetypeMap archetypes;
+
+  // [index = entity id]
+  std::vector<EntityLocation> entityLocations;
+
+  template <typename... TComponents>
+  friend class ComponentView;
+
+  template <typename TComponent>
+  Pool<TComponent> *GetOrCreatePool();
+  template <typename TComponent>
+  void RegisterComponentInfo();
+
+  // Hands out an entity id and records its creation
+  Entity NewEntity();
+
+  void IndexSystems();
+  void OnComponentAdded(Entity entity, int componentId);
+  void OnComponentRemoved(Entity entity, int componentId);
+
+  Archetype *GetOrCreateArchetype(const Signature &signature);
+  void MoveEntityToArchetype(int entityId, const Signature &newSignature);
+
   // The signature lets us know which components are turned "on" for an entity
   // [index = entity id]
   std::vector<Signature> entityComponentSignatures;
@@ -152,14 +504,30 @@ private:
   // [index = system type id]
   std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
 
+  // Systems requiring each component type, so a component change only visits
+  // the systems it may affect
+  // [index = component type id]
+  std::vector<std::vector<System *>> componentSystems;
+
+  // Systems that don't require any component, and are interested in every entity
+  std::vector<System *> systemsWithoutComponents;
+
+  // Structural changes awaiting the next frame (registry::update)
+  CommandBuffer commandBuffer;
+
   // Entities awaiting creation in the next frame (registry::update)
-  std::set<Entity> entitiesToBeAdded;
+  std::vector<Entity> entitiesToBeAdded;
+
+  // Whether the entity is still waiting to be added to the systems
+  // [index = entity id]
+  std::vector<bool> entityIsAwaitingSystems;
+  int numEntitiesAwaitingSystems = 0;
 
   // Entities awaiting destruction in the next frame (registry::update)
-  std::set<Entity> entitiesToBeKilled;
+  std::vector<Entity> entitiesToBeKilled;
 
 public:
-  Registry()
+  Registry(StorageMode storageMode = StorageMode::SparseSet) : storageMode(storageMode), commandBuffer(this)
   {
     Logger::Log("Registry constructor called!");
   };
@@ -171,11 +539,33 @@ public:
 
   void Update();
 
+  StorageMode GetStorageMode() const { return storageMode; }
+
   // Entity management
   Entity CreateEntity();
 
+  // Creates many entities at once, each one receiving a copy of the prototype components
+  template <typename... TComponents>
+  std::vector<Entity> CreateEntities(int count, const TComponents &...prototypes);
+
+  // Grows the per-entity storage once so that it can hold the given number of entities.
+  // Only the pools that already exist are grown, CreateEntities creates its pools first.
+  void Reserve(int entityCount);
+  void KillEntity(Entity entity);
+  // Whether the handle still refers to a living entity, and not to a killed one whose id got recycled
+  bool IsAlive(Entity entity) const;
+  int GetNumEntities() const { return numEntities - freeIds.size(); }
+  // One entry per component type added so far
+  std::vector<ComponentStats> GetComponentStats() const;
+
+  // Records structural changes to apply in the next Registry::Update
+  CommandBuffer &GetCommandBuffer() { return commandBuffer; }
+
   // Component management
-  // Function template to add a component of type T to a given entity
+  // Function template to add a component of type T to a given entity.
+  // Adding or removing through the handle of a killed entity logs an error and does nothing,
+  // its id may already belong to another entity. GetComponent has nothing to return then,
+  // nor when the entity doesn't have the component: it logs the error and aborts.
   template <typename TComponent, typename... TArgs>
   void AddComponent(Entity entity, TArgs &&...args);
   template <typename TComponent>
@@ -185,6 +575,10 @@ public:
   template <typename TComponent>
   TComponent &GetComponent(Entity entity) const;
 
+  // Iterate over the entities that have all the given components
+  template <typename... TComponents>
+  ComponentView<TComponents...> View();
+
   // System management
   template <typename TSystem, typename... TArgs>
   void AddSystem(TArgs &&...args);
@@ -195,6 +589,83 @@ public:
   template <typename TSystem>
   TSystem &GetSystem() const;
   void AddEntityToSystems(Entity entity);
+  void RemoveEntityFromSystems(Entity entity);
+};
+
+//////////////////////////////////////
+// ComponentView class declaration //
+//////////////////////////////////////
+
+// A view iterates over every entity owning all the given component types and
+// yields the entity along with references to its components, e.g.
+//   for (auto [entity, transform, sprite] : registry.View<TransformComponent, SpriteComponent>())
+// Nothing is allocated or copied per frame: with sparse-set storage the view
+// walks the smallest of the pools, with archetype storage it streams through
+// the chunks of every matching archetype.
+// Adding or removing components while iterating invalidates the view.
+// The view of a system, see System::View, only yields the entities of the system:
+// with sparse-set storage it walks the entity list of the system, with archetype
+// storage it skips the entities created since the last Registry::Update.
+template <typename... TComponents>
+class ComponentView
+{
+  static_assert(sizeof...(TComponents) > 0, "A view needs at least one component type");
+
+private:
+  Registry *registry;
+  Signature signature;
+
+  // Sparse-set storage: the pools of the viewed components,
+  // and the entity ids of the smallest one, which drives the iteration
+  std::tuple<Pool<TComponents> *...> pools;
+  const std::vector<int> *entityIds = nullptr;
+
+  // Set for the view of a system
+  const System *system = nullptr;
+  const std::vector<Entity> *systemEntities = nullptr;
+  // Archetype storage: some entities are not in the systems yet, check each one
+  bool isSkippingNewEntities = false;
+
+  template <typename TComponent>
+  Pool<TComponent> *GetPool() const;
+
+public:
+  ComponentView(Registry *registry, const System *system = nullptr);
+
+  class Iterator
+  {
+  private:
+    const ComponentView *view;
+
+    // Sparse-set storage: position in the entity ids of the driving pool
+    int index = 0;
+
+    // Archetype storage: current archetype, chunk, and row in the chunk
+    ArchetypeMap::const_iterator archetype;
+    int chunkIndex = 0;
+    int row = 0;
+    int chunkSize = 0;
+    const int *chunkEntityIds = nullptr;
+    std::tuple<TComponents *...> columns;
+
+    bool IsArchetypeStorage() const { return view->registry->storageMode == StorageMode::Archetype; }
+    void SkipUnmatchedEntities();
+    void SkipUnmatchedArchetypes();
+    void SkipEntitiesAwaitingSystems();
+    void LoadChunk();
+    void Advance();
+
+  public:
+    Iterator(const ComponentView *view, bool isEnd);
+
+    std::tuple<Entity, TComponents &...> operator*() const;
+    Iterator &operator++();
+    bool operator==(const Iterator &other) const;
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+  };
+
+  Iterator begin() const { return Iterator(this, false); }
+  Iterator end() const { return Iterator(this, true); }
 };
 
 //////////////////////////////////////
@@ -208,11 +679,33 @@ void System::RequireComponent()
   componentSignature.set(componentId);
 }
 
+template <typename... TComponents>
+ComponentView<TComponents...> System::View() const
+{
+  return ComponentView<TComponents...>(registry, this);
+}
+
+template <typename TComponent>
+ComponentInfo ComponentInfo::Create()
+{
+  ComponentInfo info;
+  info.name = typeid(TComponent).name();
+  info.size = sizeof(TComponent);
+  info.alignment = alignof(TComponent);
+  info.moveConstruct = [](void *destination, void *source)
+  { new (destination) TComponent(std::move(*static_cast<TComponent *>(source))); };
+  info.destroy = [](void *component)
+  { static_cast<TComponent *>(component)->~TComponent(); };
+  return info;
+}
+
 template <typename TSystem, typename... TArgs>
 void Registry::AddSystem(TArgs &&...args)
 {
   std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
+  newSystem->registry = this;
   systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+  IndexSystems();
 }
 
 template <typename TSystem>
@@ -233,15 +726,15 @@ void Registry::RemoveSystem()
 {
   auto system = systems.find(std::type_index(typeid(TSystem)));
   systems.erase(system);
+  IndexSystems();
 }
 
-template <typename TComponent, typename... TArgs>
-void Registry::AddComponent(Entity entity, TArgs &&...args)
+template <typename TComponent>
+Pool<TComponent> *Registry::GetOrCreatePool()
 {
   const auto componentId = Component<TComponent>::GetId();
-  const auto entityId = entity.GetId();
 
-  if (componentId >= componentPools.size())
+  if (componentId >= static_cast<int>(componentPools.size()))
   {
     componentPools.resize(componentId + 1, nullptr);
   }
@@ -251,26 +744,145 @@ void Registry::AddComponent(Entity entity, TArgs &&...args)
   {
     std::shared_ptr<Pool<TComponent>> newPool = std::make_shared<Pool<TComponent>>();
     componentPools[componentId] = newPool;
+    RegisterComponentInfo<TComponent>();
+  }
+
+  return static_cast<Pool<TComponent> *>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+void Registry::RegisterComponentInfo()
+{
+  const auto componentId = Component<TComponent>::GetId();
+
+  if (componentId >= static_cast<int>(componentInfos.size()))
+  {
+    componentInfos.resize(componentId + 1);
+  }
+
+  // Register the type-erased operations the first time we see this component type
+  if (!componentInfos[componentId].destroy)
+  {
+    componentInfos[componentId] = ComponentInfo::Create<TComponent>();
+  }
+}
+
+template <typename... TComponents>
+std::vector<Entity> Registry::CreateEntities(int count, const TComponents &...prototypes)
+{
+  std::vector<Entity> entities;
+  entities.reserve(count);
+
+  // The pools must exist before the reserve below, so that their sparse arrays grow as well
+  if (storageMode == StorageMode::SparseSet)
+  {
+    (GetOrCreatePool<TComponents>(), ...);
+  }
+
+  // Grow every per-entity vector once, for the worst case where no id gets recycled
+  Reserve(numEntities + count);
+
+  Signature signature;
+  (signature.set(Component<TComponents>::GetId()), ...);
+
+  if (storageMode == StorageMode::Archetype)
+  {
+    (RegisterComponentInfo<TComponents>(), ...);
+
+    // Every new entity goes straight into the archetype of its final signature
+    Archetype *archetype = signature.none() ? nullptr : GetOrCreateArchetype(signature);
+    if (archetype)
+    {
+      archetype->Reserve(archetype->GetNumEntities() + count);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+      Entity entity = NewEntity();
+      const auto entityId = entity.GetId();
+      entityComponentSignatures[entityId] = signature;
+
+      if (archetype)
+      {
+        const int row = archetype->AddEntity(entityId);
+        entityLocations[entityId].archetype = archetype;
+        entityLocations[entityId].row = row;
+        (new (archetype->GetComponent(Component<TComponents>::GetId(), row)) TComponents(prototypes), ...);
+      }
+      entities.push_back(entity);
+    }
+  }
+  else
+  {
+    std::tuple<Pool<TComponents> *...> pools(GetOrCreatePool<TComponents>()...);
+    (std::get<Pool<TComponents> *>(pools)->Reserve(std::get<Pool<TComponents> *>(pools)->GetSize() + count), ...);
+
+    for (int i = 0; i < count; i++)
+    {
+      Entity entity = NewEntity();
+      const auto entityId = entity.GetId();
+      entityComponentSignatures[entityId] = signature;
+      (std::get<Pool<TComponents> *>(pools)->Emplace(entityId, prototypes), ...);
+      entities.push_back(entity);
+    }
   }
 
-  // Get the pool of component values for that component type
-  std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+  // The new entities join their systems in the next Registry::Update
+  LOG_TRACE(ECS, "%d entities created", count);
+
+  return entities;
+}
 
-  if (entityId >= componentPool->GetSize())
+template <typename TComponent, typename... TArgs>
+void Registry::AddComponent(Entity entity, TArgs &&...args)
+{
+  const auto componentId = Component<TComponent>::GetId();
+  const auto entityId = entity.GetId();
+
+  if (!IsAlive(entity))
   {
-    componentPool->Resize(numEntities);
+    Logger::Errf("AddComponent called with the handle of killed entity id %d", entityId);
+    return;
   }
 
-  // Create the component and forward the various parameters to the constructor
-  TComponent newComponent(std::forward<TArgs>(args)...);
+  if (storageMode == StorageMode::Archetype)
+  {
+    RegisterComponentInfo<TComponent>();
+
+    if (entityComponentSignatures[entityId].test(componentId))
+    {
+      // The entity already has this component, simply replace it
+      GetComponent<TComponent>(entity) = TComponent(std::forward<TArgs>(args)...);
+    }
+    else
+    {
+      // Move the entity to the archetype matching its new signature,
+      // then create the new component directly inside its column
+      Signature newSignature = entityComponentSignatures[entityId];
+      newSignature.set(componentId);
+      MoveEntityToArchetype(entityId, newSignature);
+
+      const EntityLocation &location = entityLocations[entityId];
+      new (location.archetype->GetComponent(componentId, location.row)) TComponent(std::forward<TArgs>(args)...);
+    }
+  }
+  else
+  {
+    // Get the pool of component values for that component type
+    Pool<TComponent> *componentPool = GetOrCreatePool<TComponent>();
 
-  // Add the component to the pool
-  componentPool->Set(entityId, newComponent);
+    // Forward the various parameters to construct the component directly inside the pool
+    componentPool->Emplace(entityId, std::forward<TArgs>(args)...);
+  }
 
   // Update the signature of the entity to show that it has the component
-  entityComponentSignatures[entityId].set(componentId);
+  if (!entityComponentSignatures[entityId].test(componentId))
+  {
+    entityComponentSignatures[entityId].set(componentId);
+    OnComponentAdded(entity, componentId);
+  }
 
-  Logger::Log("Component id = " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
+  LOG_TRACE(ECS, "Component id = %d was added to entity id %d", componentId, entityId);
 }
 
 template <typename TComponent>
@@ -279,16 +891,39 @@ void Registry::RemoveComponent(Entity entity)
   const auto componentId = Component<TComponent>::GetId();
   const auto entityId = entity.GetId();
 
-  // Get the pool of component values for that component type
-  auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+  if (!IsAlive(entity))
+  {
+    Logger::Errf("RemoveComponent called with the handle of killed entity id %d", entityId);
+    return;
+  }
+
+  // Without the component there may not even be a pool for its type
+  if (!entityComponentSignatures[entityId].test(componentId))
+  {
+    return;
+  }
+
+  if (storageMode == StorageMode::Archetype)
+  {
+    // Moving the entity to its new archetype leaves the removed component behind, where it gets destroyed
+    Signature newSignature = entityComponentSignatures[entityId];
+    newSignature.reset(componentId);
+    MoveEntityToArchetype(entityId, newSignature);
+  }
+  else
+  {
+    // Get the pool of component values for that component type
+    Pool<TComponent> *componentPool = static_cast<Pool<TComponent> *>(componentPools[componentId].get());
 
-  // Remove the component from the pool
-  componentPool->Set(entityId, TComponent());
+    // Remove the component from the pool
+    componentPool->Remove(entityId);
+  }
 
   // Update the signature of the entity to show that it no longer has the component
   entityComponentSignatures[entityId].set(componentId, false);
+  OnComponentRemoved(entity, componentId);
 
-  Logger::Log("Component id = " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId));
+  LOG_TRACE(ECS, "Component id = %d was removed from entity id %d", componentId, entityId);
 }
 
 template <typename TComponent>
@@ -297,7 +932,7 @@ bool Registry::HasComponent(Entity entity) const
   const auto componentId = Component<TComponent>::GetId();
   const auto entityId = entity.GetId();
 
-  return entityComponentSignatures[entityId].test(componentId);
+  return IsAlive(entity) && entityComponentSignatures[entityId].test(componentId);
 }
 
 template <typename TComponent>
@@ -306,8 +941,265 @@ TComponent &Registry::GetComponent(Entity entity) const
   const auto componentId = Component<TComponent>::GetId();
   const auto entityId = entity.GetId();
 
-  auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-  return componentPool->Get(entityId);
+  // Checked in release builds too: a stale handle would silently read the components of another entity
+  if (!IsAlive(entity) || !entityComponentSignatures[entityId].test(componentId))
+  {
+    Logger::Errf("GetComponent called with entity id %d, killed or without component id %d", entityId, componentId);
+    Logger::Flush();
+    std::abort();
+  }
+
+  if (storageMode == StorageMode::Archetype)
+  {
+    const EntityLocation &location = entityLocations[entityId];
+    return *static_cast<TComponent *>(location.archetype->GetComponent(componentId, location.row));
+  }
+
+  // A plain cast: copying the shared_ptr would touch its atomic reference count on every lookup
+  return static_cast<Pool<TComponent> *>(componentPools[componentId].get())->Get(entityId);
+}
+
+template <typename... TComponents>
+ComponentView<TComponents...> Registry::View()
+{
+  return ComponentView<TComponents...>(this);
+}
+
+template <typename... TComponents>
+ComponentView<TComponents...>::ComponentView(Registry *registry, const System *system) : registry(registry), system(system)
+{
+  (signature.set(Component<TComponents>::GetId()), ...);
+  if (system)
+  {
+    signature |= system->GetComponentSignature();
+  }
+
+  if (registry->storageMode == StorageMode::Archetype)
+  {
+    isSkippingNewEntities = system && registry->numEntitiesAwaitingSystems > 0;
+    return;
+  }
+
+  // Fetch the pool of each component type, the view is empty if one of them doesn't exist yet
+  pools = std::make_tuple(GetPool<TComponents>()...);
+
+  const bool hasAllPools = ((std::get<Pool<TComponents> *>(pools) != nullptr) && ...);
+  if (!hasAllPools)
+  {
+    return;
+  }
+
+  // The entities of a system always have its components, no need to check their signature
+  if (system)
+  {
+    systemEntities = &system->GetSystemEntities();
+    return;
+  }
+
+  // Drive the iteration with the smallest pool to visit as few entities as possible
+  auto selectSmallest = [this](auto *pool)
+  {
+    if (!entityIds || pool->GetEntityIds().size() < entityIds->size())
+    {
+      entityIds = &pool->GetEntityIds();
+    }
+  };
+  (selectSmallest(std::get<Pool<TComponents> *>(pools)), ...);
+}
+
+template <typename... TComponents>
+template <typename TComponent>
+Pool<TComponent> *ComponentView<TComponents...>::GetPool() const
+{
+  const auto componentId = Component<TComponent>::GetId();
+  if (componentId >= static_cast<int>(registry->componentPools.size()))
+  {
+    return nullptr;
+  }
+  return static_cast<Pool<TComponent> *>(registry->componentPools[componentId].get());
+}
+
+template <typename... TComponents>
+ComponentView<TComponents...>::Iterator::Iterator(const ComponentView *view, bool isEnd) : view(view)
+{
+  if (IsArchetypeStorage())
+  {
+    const ArchetypeMap &archetypes = view->registry->archetypes;
+    archetype = isEnd ? archetypes.end() : archetypes.begin();
+    SkipUnmatchedArchetypes();
+    SkipEntitiesAwaitingSystems();
+  }
+  else if (view->systemEntities)
+  {
+    index = isEnd ? view->systemEntities->size() : 0;
+  }
+  else
+  {
+    if (view->entityIds)
+    {
+      index = isEnd ? view->entityIds->size() : 0;
+      SkipUnmatchedEntities();
+    }
+  }
+}
+
+template <typename... TComponents>
+void ComponentView<TComponents...>::Iterator::SkipUnmatchedEntities()
+{
+  const auto &entityIds = *view->entityIds;
+  const auto &signatures = view->registry->entityComponentSignatures;
+  while (index < static_cast<int>(entityIds.size()) &&
+         (signatures[entityIds[index]] & view->signature) != view->signature)
+  {
+    index++;
+  }
+}
+
+template <typename... TComponents>
+void ComponentView<TComponents...>::Iterator::SkipUnmatchedArchetypes()
+{
+  const ArchetypeMap &archetypes = view->registry->archetypes;
+  while (archetype != archetypes.end())
+  {
+    const Archetype &current = *archetype->second;
+    if ((current.GetSignature() & view->signature) == view->signature && current.GetNumEntities() > 0)
+    {
+      LoadChunk();
+      return;
+    }
+    ++archetype;
+  }
+}
+
+template <typename... TComponents>
+void ComponentView<TComponents...>::Iterator::SkipEntitiesAwaitingSystems()
+{
+  if (!view->isSkippingNewEntities)
+  {
+    return;
+  }
+  const auto &isAwaitingSystems = view->registry->entityIsAwaitingSystems;
+  while (archetype != view->registry->archetypes.end() && isAwaitingSystems[chunkEntityIds[row]])
+  {
+    Advance();
+  }
+}
+
+template <typename... TComponents>
+void ComponentView<TComponents...>::Iterator::LoadChunk()
+{
+  const Archetype &current = *archetype->second;
+  chunkSize = current.GetChunkSize(chunkIndex);
+  chunkEntityIds = current.GetEntityIds(chunkIndex);
+  columns = std::make_tuple(static_cast<TComponents *>(current.GetColumn(Component<TComponents>::GetId(), chunkIndex))...);
+}
+
+template <typename... TComponents>
+std::tuple<Entity, TComponents &...> ComponentView<TComponents...>::Iterator::operator*() const
+{
+  if (IsArchetypeStorage())
+  {
+    Entity entity(chunkEntityIds[row], view->registry->entityGenerations[chunkEntityIds[row]]);
+    entity.registry = view->registry;
+    return std::tuple<Entity, TComponents &...>(entity, std::get<TComponents *>(columns)[row]...);
+  }
+
+  if (view->systemEntities)
+  {
+    Entity entity = (*view->systemEntities)[index];
+    entity.registry = view->registry;
+    return std::tuple<Entity, TComponents &...>(entity, std::get<Pool<TComponents> *>(view->pools)->Get(entity.GetId())...);
+  }
+
+  const int entityId = (*view->entityIds)[index];
+  Entity entity(entityId, view->registry->entityGenerations[entityId]);
+  entity.registry = view->registry;
+  return std::tuple<Entity, TComponents &...>(entity, std::get<Pool<TComponents> *>(view->pools)->Get(entityId)...);
+}
+
+template <typename... TComponents>
+typename ComponentView<TComponents...>::Iterator &ComponentView<TComponents...>::Iterator::operator++()
+{
+  if (IsArchetypeStorage())
+  {
+    // Most of the time the next row is in the same chunk
+    if (row + 1 < chunkSize && !view->isSkippingNewEntities)
+    {
+      row++;
+      return *this;
+    }
+    Advance();
+    SkipEntitiesAwaitingSystems();
+    return *this;
+  }
+
+  index++;
+  if (!view->systemEntities)
+  {
+    SkipUnmatchedEntities();
+  }
+  return *this;
+}
+
+// Archetype storage: moves to the next row of the matching archetypes
+template <typename... TComponents>
+void ComponentView<TComponents...>::Iterator::Advance()
+{
+  if (++row < chunkSize)
+  {
+    return;
+  }
+
+  // Move on to the next chunk, or to the next matching archetype
+  row = 0;
+  chunkIndex++;
+  if (chunkIndex < archetype->second->GetNumChunks() && archetype->second->GetChunkSize(chunkIndex) > 0)
+  {
+    LoadChunk();
+    return;
+  }
+
+  chunkIndex = 0;
+  ++archetype;
+  SkipUnmatchedArchetypes();
+}
+
+template <typename... TComponents>
+bool ComponentView<TComponents...>::Iterator::operator==(const Iterator &other) const
+{
+  if (IsArchetypeStorage())
+  {
+    return archetype == other.archetype && chunkIndex == other.chunkIndex && row == other.row;
+  }
+  return index == other.index;
+}
+
+template <typename TComponent, typename... TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs &&...args)
+{
+  // Build the component right away in the arena, it will be moved into the registry on playback
+  void *payload = Allocate(sizeof(TComponent), alignof(TComponent));
+  new (payload) TComponent(std::forward<TArgs>(args)...);
+
+  Command command{CommandType::ChangeComponent, entity, nullptr, nullptr, payload};
+  command.apply = [](Registry &registry, Entity entity, void *payload)
+  {
+    TComponent *component = static_cast<TComponent *>(payload);
+    registry.AddComponent<TComponent>(entity, std::move(*component));
+    component->~TComponent();
+  };
+  command.discard = [](void *payload)
+  { static_cast<TComponent *>(payload)->~TComponent(); };
+  commands.push_back(command);
+}
+
+template <typename TComponent>
+void CommandBuffer::RemoveComponent(Entity entity)
+{
+  Command command{CommandType::ChangeComponent, entity, nullptr, nullptr, nullptr};
+  command.apply = [](Registry &registry, Entity entity, void *)
+  { registry.RemoveComponent<TComponent>(entity); };
+  commands.push_back(command);
 }
 
 template <typename TComponent, typename... TArgs>
@@ -0,0 +1,219 @@
+#include "DebugOverlay.h"
+#include "FrameLimiter.h"
+#include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
+#include <imgui/imgui.h>
+#include <imgui/imgui_sdl.h>
+
+void DebugOverlay::Initialize(SDL_Renderer *renderer, int width, int height)
+{
+  ImGui::CreateContext();
+  ImGui::StyleColorsDark();
+  // Nothing to remember from one session to the next
+  ImGui::GetIO().IniFilename = nullptr;
+  ImGuiSDL::Initialize(renderer, width, height);
+  isInitialized = true;
+}
+
+void DebugOverlay::Destroy()
+{
+  if (!isInitialized)
+  {
+    return;
+  }
+  Profiler::SetSummaryEnabled(false);
+  ImGuiSDL::Deinitialize();
+  ImGui::DestroyContext();
+  isInitialized = false;
+}
+
+void DebugOverlay::Toggle()
+{
+  isVisible = isInitialized && !isVisible;
+  Profiler::SetSummaryEnabled(isVisible);
+}
+
+void DebugOverlay::ProcessEvent(const SDL_Event &event)
+{
+  if (isVisible && event.type == SDL_MOUSEWHEEL)
+  {
+    mouseWheel += event.wheel.y;
+  }
+}
+
+void DebugOverlay::Render(const Registry &registry, const FrameLimiter &frameLimiter)
+{
+  if (!isVisible)
+  {
+    return;
+  }
+  PROFILE_ZONE("DebugOverlay::Render");
+
+  ImGuiIO &io = ImGui::GetIO();
+  const int numFrames = frameLimiter.GetNumFrameDurations();
+  const double lastFrameDuration = numFrames > 0 ? frameLimiter.GetFrameDuration(numFrames - 1) : 0.0;
+  io.DeltaTime = lastFrameDuration > 0.0 ? static_cast<float>(lastFrameDuration / 1000.0) : 1.0f / 60.0f;
+
+  int mouseX, mouseY;
+  const Uint32 buttons = SDL_GetMouseState(&mouseX, &mouseY);
+  io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
+  io.MouseDown[0] = (buttons & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
+  io.MouseDown[1] = (buttons & SDL_BUTTON(SDL_BUTTON_RIGHT)) != 0;
+  io.MouseWheel = mouseWheel;
+  mouseWheel = 0.0f;
+
+  ImGui::NewFrame();
+  ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(420, 600), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Performance (F1)");
+
+  RenderFrameTimes(frameLimiter);
+  RenderZones();
+  RenderComponents(registry);
+  RenderLog();
+
+  ImGui::End();
+  ImGui::Render();
+  ImGuiSDL::Render(ImGui::GetDrawData());
+}
+
+void DebugOverlay::RenderFrameTimes(const FrameLimiter &frameLimiter)
+{
+  if (!ImGui::CollapsingHeader("Frame times", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    return;
+  }
+
+  const FrameStats stats = frameLimiter.GetStats();
+  ImGui::Text("mean %.2f ms (%.0f FPS)  p99 %.2f ms  max %.2f ms",
+              stats.mean, stats.mean > 0.0 ? 1000.0 / stats.mean : 0.0, stats.p99, stats.max);
+
+  auto getFrameDuration = [](void *data, int index)
+  {
+    return static_cast<float>(static_cast<const FrameLimiter *>(data)->GetFrameDuration(index));
+  };
+  ImGui::PlotLines("##Frame times", getFrameDuration, const_cast<FrameLimiter *>(&frameLimiter), frameLimiter.GetNumFrameDurations(),
+                   0, nullptr, 0.0f, static_cast<float>(stats.max), ImVec2(-1, 80));
+}
+
+void DebugOverlay::RenderZones()
+{
+  if (!ImGui::CollapsingHeader("Zones, last frame", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    return;
+  }
+
+  ImGui::Columns(3, "zones");
+  ImGui::Text("Zone");
+  ImGui::NextColumn();
+  ImGui::Text("ms");
+  ImGui::NextColumn();
+  ImGui::Text("Calls");
+  ImGui::NextColumn();
+  ImGui::Separator();
+  for (const ProfileZoneSummary &zone : Profiler::GetFrameSummary())
+  {
+    ImGui::TextUnformatted(zone.name);
+    ImGui::NextColumn();
+    ImGui::Text("%.3f", zone.milliseconds);
+    ImGui::NextColumn();
+    ImGui::Text("%d", zone.count);
+    ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+}
+
+void DebugOverlay::RenderComponents(const Registry &registry)
+{
+  if (!ImGui::CollapsingHeader("Entities", ImGuiTreeNodeFlags_DefaultOpen))
+  {
+    return;
+  }
+
+  ImGui::Text("%d entities", registry.GetNumEntities());
+
+  ImGui::Columns(3, "components");
+  ImGui::Text("Component");
+  ImGui::NextColumn();
+  ImGui::Text("Count");
+  ImGui::NextColumn();
+  ImGui::Text("KiB");
+  ImGui::NextColumn();
+  ImGui::Separator();
+  size_t totalMemoryUsage = 0;
+  for (const ComponentStats &stats : registry.GetComponentStats())
+  {
+    ImGui::TextUnformatted(stats.name.c_str());
+    ImGui::NextColumn();
+    ImGui::Text("%d", stats.numComponents);
+    ImGui::NextColumn();
+    ImGui::Text("%.1f", stats.memoryUsage / 1024.0);
+    ImGui::NextColumn();
+    totalMemoryUsage += stats.memoryUsage;
+  }
+  ImGui::Columns(1);
+  ImGui::Text("Total %.1f KiB", totalMemoryUsage / 1024.0);
+}
+
+void DebugOverlay::RenderLog()
+{
+  if (!ImGui::CollapsingHeader("Log"))
+  {
+    return;
+  }
+
+  ImGui::Checkbox("Info", &isInfoShown);
+  ImGui::SameLine();
+  ImGui::Checkbox("Warning", &isWarningShown);
+  ImGui::SameLine();
+  ImGui::Checkbox("Error", &isErrorShown);
+
+  unsigned int typeMask = 0;
+  const std::pair<LogType, bool> types[] = {{LOG_INFO, isInfoShown}, {LOG_WARNING, isWarningShown}, {LOG_ERROR, isErrorShown}};
+  for (const auto &[type, isShown] : types)
+  {
+    if (isShown)
+    {
+      typeMask |= LogTypeMask(type);
+    }
+  }
+
+  ImGui::BeginChild("log", ImVec2(0, 200), true);
+  const bool isAtBottom = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+
+  // Only the lines in view are copied, at once, and drawn after the history is unlocked.
+  // The lines all have the same height, so the scrolling tells which ones are in view.
+  const float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+  const int firstLine = static_cast<int>(ImGui::GetScrollY() / lineHeight);
+  const int numLines = static_cast<int>(ImGui::GetWindowHeight() / lineHeight) + 2;
+  const int numEntries = static_cast<int>(Logger::GetHistory().CopyEntries(firstLine, firstLine + numLines, typeMask, logMessages));
+
+  ImGuiListClipper clipper;
+  clipper.Begin(numEntries, lineHeight);
+  while (clipper.Step())
+  {
+    for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++)
+    {
+      const int index = line - firstLine;
+      if (index < 0 || index >= static_cast<int>(logMessages.size()))
+      {
+        // Out of the copied lines, only while the scrolling moves
+        ImGui::TextUnformatted("");
+        continue;
+      }
+      const LogHistoryMessage &message = logMessages[index];
+      const ImVec4 color = message.type == LOG_ERROR ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(0.6f, 1.0f, 0.6f, 1.0f);
+      ImGui::PushStyleColor(ImGuiCol_Text, color);
+      ImGui::TextUnformatted(message.message.data(), message.message.data() + message.message.size());
+      ImGui::PopStyleColor();
+    }
+  }
+  clipper.End();
+
+  // Follow the new messages, unless scrolled up to read older ones
+  if (isAtBottom)
+  {
+    ImGui::SetScrollHereY(1.0f);
+  }
+  ImGui::EndChild();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "../Logger/LogHistory.h"
+#include <SDL.h>
+#include <vector>
+
+class Registry;
+class FrameLimiter;
+
+// In-game performance overlay drawn with Dear ImGui: frame time graph, time
+// spent in each profiler zone during the last frame, entity count, size and
+// memory of every component pool, and the log history.
+// While hidden it costs nothing: ImGui doesn't run a frame and the profiler
+// stops summarizing the zones.
+class DebugOverlay
+{
+private:
+  bool isInitialized = false;
+  bool isVisible = false;
+
+  // Mouse wheel movement since the last frame
+  float mouseWheel = 0.0f;
+
+  // Log types shown in the log history
+  bool isInfoShown = true;
+  bool isWarningShown = true;
+  bool isErrorShown = true;
+  // Copy of the log lines in view, kept between frames to reuse the strings
+  std::vector<LogHistoryMessage> logMessages;
+
+  void RenderFrameTimes(const FrameLimiter &frameLimiter);
+  void RenderZones();
+  void RenderComponents(const Registry &registry);
+  void RenderLog();
+
+public:
+  void Initialize(SDL_Renderer *renderer, int width, int height);
+  void Destroy();
+
+  void Toggle();
+  bool IsVisible() const { return isVisible; }
+
+  // Forwards the input the overlay needs to ImGui
+  void ProcessEvent(const SDL_Event &event);
+
+  void Render(const Registry &registry, const FrameLimiter &frameLimiter);
+};
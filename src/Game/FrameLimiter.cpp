@@ -0,0 +1,96 @@
+#include "FrameLimiter.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <numeric>
+
+FrameLimiter::FrameLimiter(FrameLimiterMode mode, double targetFrameRate) : mode(mode), frameDurations(FRAME_STATS_WINDOW)
+{
+  secondsPerCount = 1.0 / SDL_GetPerformanceFrequency();
+  SetTargetFrameRate(targetFrameRate);
+}
+
+void FrameLimiter::SetMode(FrameLimiterMode mode)
+{
+  this->mode = mode;
+  nextFrameCounter = SDL_GetPerformanceCounter() + targetFrameCounts;
+}
+
+void FrameLimiter::SetTargetFrameRate(double framesPerSecond)
+{
+  // Also false for NaN
+  if (!(framesPerSecond > 0.0))
+  {
+    Logger::Errf("Invalid target frame rate %.2f, keeping the previous one", framesPerSecond);
+    return;
+  }
+  targetFrameCounts = static_cast<Uint64>(SDL_GetPerformanceFrequency() / framesPerSecond);
+  nextFrameCounter = SDL_GetPerformanceCounter() + targetFrameCounts;
+}
+
+void FrameLimiter::Start()
+{
+  previousFrameCounter = SDL_GetPerformanceCounter();
+  nextFrameCounter = previousFrameCounter + targetFrameCounts;
+  numFrames = 0;
+}
+
+double FrameLimiter::WaitForNextFrame()
+{
+  if (mode == FRAME_LIMIT_TARGET)
+  {
+    PROFILE_ZONE("FrameLimiter::WaitForNextFrame");
+    const Uint64 spinCounts = static_cast<Uint64>(FRAME_LIMITER_SPIN_TIME / secondsPerCount);
+    Uint64 counter = SDL_GetPerformanceCounter();
+
+    // Sleep by small steps while far from the deadline, then spin until it
+    while (counter + spinCounts < nextFrameCounter)
+    {
+      SDL_Delay(1);
+      counter = SDL_GetPerformanceCounter();
+    }
+    while (counter < nextFrameCounter)
+    {
+      counter = SDL_GetPerformanceCounter();
+    }
+
+    // A frame running long moves the grid rather than trying to catch up with fast frames
+    nextFrameCounter += targetFrameCounts;
+    if (nextFrameCounter < counter)
+    {
+      nextFrameCounter = counter + targetFrameCounts;
+    }
+  }
+
+  const Uint64 frameCounter = SDL_GetPerformanceCounter();
+  const double frameTime = (frameCounter - previousFrameCounter) * secondsPerCount;
+  previousFrameCounter = frameCounter;
+
+  frameDurations[numFrames % FRAME_STATS_WINDOW] = frameTime * 1000.0;
+  numFrames++;
+  return frameTime;
+}
+
+double FrameLimiter::GetFrameDuration(int index) const
+{
+  const int oldest = numFrames - GetNumFrameDurations();
+  return frameDurations[(oldest + index) % FRAME_STATS_WINDOW];
+}
+
+FrameStats FrameLimiter::GetStats() const
+{
+  FrameStats stats;
+  stats.numFrames = std::min(numFrames, FRAME_STATS_WINDOW);
+  if (stats.numFrames == 0)
+  {
+    return stats;
+  }
+
+  std::vector<double> durations(frameDurations.begin(), frameDurations.begin() + stats.numFrames);
+  stats.mean = std::accumulate(durations.begin(), durations.end(), 0.0) / stats.numFrames;
+  stats.max = *std::max_element(durations.begin(), durations.end());
+  auto p99 = durations.begin() + (stats.numFrames - 1) * 99 / 100;
+  std::nth_element(durations.begin(), p99, durations.end());
+  stats.p99 = *p99;
+  return stats;
+}
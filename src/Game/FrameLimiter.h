@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+enum FrameLimiterMode
+{
+  FRAME_LIMIT_TARGET,   // Wait until the target frame duration has passed, vsync off
+  FRAME_LIMIT_VSYNC,    // Let the vsync of the renderer pace the frames
+  FRAME_LIMIT_UNCAPPED, // Run as fast as possible
+};
+
+// Number of frames the stats are computed over
+const int FRAME_STATS_WINDOW = 600;
+
+// Sleeping isn't precise enough to stop right at the end of a frame, the limiter
+// only sleeps until this close to it and spins the rest of the way
+const double FRAME_LIMITER_SPIN_TIME = 0.002;
+
+// Frame durations in milliseconds, over the last FRAME_STATS_WINDOW frames
+struct FrameStats
+{
+  int numFrames = 0;
+  double mean = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+// Paces the game loop on the high resolution clock (SDL_GetPerformanceCounter)
+// and keeps the durations of the last frames for the stats.
+// The frames are scheduled on a fixed grid, so the sleeping error of one frame
+// is made up for by the next one instead of accumulating.
+class FrameLimiter
+{
+private:
+  FrameLimiterMode mode;
+  double secondsPerCount;
+  Uint64 targetFrameCounts = 0;
+  Uint64 nextFrameCounter = 0;
+  Uint64 previousFrameCounter = 0;
+
+  // Circular buffer of the last frame durations, in milliseconds
+  std::vector<double> frameDurations;
+  int numFrames = 0;
+
+public:
+  FrameLimiter(FrameLimiterMode mode, double targetFrameRate);
+
+  void SetMode(FrameLimiterMode mode);
+  FrameLimiterMode GetMode() const { return mode; }
+  // Logs an error and changes nothing unless framesPerSecond is positive, use FRAME_LIMIT_UNCAPPED for no limit
+  void SetTargetFrameRate(double framesPerSecond);
+
+  // Starts the clock, call it right before the game loop
+  void Start();
+
+  // Waits for the start of the next frame if the mode asks for it,
+  // returns the duration of the frame that just ended, in seconds
+  double WaitForNextFrame();
+
+  FrameStats GetStats() const;
+
+  // Durations of the last frames in milliseconds, index 0 being the oldest
+  int GetNumFrameDurations() const { return numFrames < FRAME_STATS_WINDOW ? numFrames : FRAME_STATS_WINDOW; }
+  double GetFrameDuration(int index) const;
+};
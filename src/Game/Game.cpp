@@ -1,17 +1,21 @@
 #include "Game.h"
 #include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
 #include "../ECS/ECS.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 #include "../Components/SpriteComponent.h"
 #include "../Sytems/MovementSystem.h"
 #include "../Sytems/RenderSystem.h"
+#include "../AssetStore/Atlas.h"
+#include <cmath>
 #include <iostream>
 
 Game::Game()
 {
   isRunning = false;
   registry = std::make_unique<Registry>();
+  assetStore = std::make_unique<AssetStore>();
   Logger::Log("Game constructor called!");
 }
 
@@ -22,6 +26,18 @@ Game::~Game()
 
 void Game::Initialize()
 {
+  if (isHeadless)
+  {
+    // Only the timer, and the events so that the game still quits on Ctrl+C
+    if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+    {
+      Logger::Err("Error initializing SDL.");
+      return;
+    }
+    isRunning = true;
+    return;
+  }
+
   if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
   {
     Logger::Err("Erro initializing SDL.");
@@ -49,15 +65,26 @@ void Game::Initialize()
     return;
   }
 
+  // Only wait for the vsync when it paces the frames, the frame limiter would fight it otherwise
+  Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+  if (frameLimiter.GetMode() == FRAME_LIMIT_VSYNC)
+  {
+    rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+  }
   renderer = SDL_CreateRenderer(
       window,
       -1,
-      SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+      rendererFlags);
   if (renderer == NULL)
   {
     Logger::Err("Error creating SDL renderer");
     return;
   }
+  int rendererWidth, rendererHeight;
+  SDL_GetRendererOutputSize(renderer, &rendererWidth, &rendererHeight);
+  camera = {0, 0, rendererWidth, rendererHeight};
+  debugOverlay.Initialize(renderer, rendererWidth, rendererHeight);
+
   // Change the video mode of my display to become a "real" fullscreen
   // SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
 
@@ -66,9 +93,11 @@ void Game::Initialize()
 
 void Game::ProcessInput()
 {
+  PROFILE_ZONE("Game::ProcessInput");
   SDL_Event sdlEvent;
   while (SDL_PollEvent(&sdlEvent))
   {
+    debugOverlay.ProcessEvent(sdlEvent);
     switch (sdlEvent.type)
     {
     case SDL_QUIT:
@@ -79,77 +108,247 @@ void Game::ProcessInput()
       {
         isRunning = false;
       }
+      if (sdlEvent.key.keysym.sym == SDLK_F1)
+      {
+        debugOverlay.Toggle();
+      }
+      break;
+    case SDL_RENDER_TARGETS_RESET:
+      // The baked chunks of the tilemap were lost
+      tilemap.Invalidate();
       break;
     }
   }
 }
 
+// Sprite of the image from assets/images, taken from the atlas when it has it so
+// that the whole scene shares a texture, loaded on its own otherwise
+static SpriteComponent LoadSprite(AssetStore &assetStore, SDL_Renderer *renderer, const std::string &imageName, int width, int height)
+{
+  if (const AtlasSprite *atlasSprite = assetStore.FindAtlasSprite(imageName))
+  {
+    return SpriteComponent(atlasSprite->width, atlasSprite->height, atlasSprite->textureId, atlasSprite->x, atlasSprite->y);
+  }
+  // Textures need a renderer, the headless mode draws nothing anyway
+  if (renderer == nullptr)
+  {
+    return SpriteComponent(width, height);
+  }
+  return SpriteComponent(width, height, assetStore.AddTexture(renderer, "./assets/images/" + imageName + ".png"));
+}
+
 void Game::Setup()
 {
   // Add the systems that need to be processed in our game
   registry->AddSystem<MovementSystem>();
   registry->AddSystem<RenderSystem>();
 
+  // Built by make atlas
+  if (renderer && !assetStore->AddAtlas(renderer, ATLAS_PATH))
+  {
+    Logger::Log("No texture atlas, loading the images one by one");
+  }
+
+  // Background, 32x32 tiles drawn twice as big. The binary tilemap is built by make tilemaps.
+  const int tilesetTextureId = renderer ? assetStore->AddTexture(renderer, "./assets/tilemaps/jungle.png") : NO_TEXTURE;
+  if (!tilemap.LoadBinary("./assets/tilemaps/jungle.tmb", *assetStore, tilesetTextureId, 32, 2.0f))
+  {
+    tilemap.Load("./assets/tilemaps/jungle.map", *assetStore, tilesetTextureId, 32, 2.0f);
+  }
+
   // Create an entity
   Entity tank = registry->CreateEntity();
   tank.AddComponent<TransformComponent>(glm::vec2(10.0, 30.0), glm::vec2(1.0, 1.0), 0.0);
   tank.AddComponent<RigidBodyComponent>(glm::vec2(50.0, 0.0));
-  tank.AddComponent<SpriteComponent>(10, 10);
+  tank.AddComponent<SpriteComponent>(LoadSprite(*assetStore, renderer, "tank-panther-right", 32, 32));
 
   Entity truck = registry->CreateEntity();
   truck.AddComponent<TransformComponent>(glm::vec2(50.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
   truck.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 50.0));
-  truck.AddComponent<SpriteComponent>(10, 50);
+  truck.AddComponent<SpriteComponent>(LoadSprite(*assetStore, renderer, "truck-ford-down", 32, 32));
 }
 
-void Game::Update()
+void Game::SetSimulationRate(int stepsPerSecond)
+{
+  if (stepsPerSecond <= 0)
+  {
+    Logger::Errf("Invalid simulation rate %d, keeping the previous one", stepsPerSecond);
+    return;
+  }
+  fixedDeltaTime = 1.0 / stepsPerSecond;
+}
+
+void Game::SetFrameLimit(FrameLimiterMode mode, double targetFrameRate)
+{
+  frameLimiter.SetMode(mode);
+  frameLimiter.SetTargetFrameRate(targetFrameRate);
+  if (renderer)
+  {
+    SDL_RenderSetVSync(renderer, mode == FRAME_LIMIT_VSYNC ? 1 : 0);
+  }
+}
+
+FrameStats Game::GetFrameStats() const
 {
-  // If we are too fast, waste some time until we reach the MILLISECS_PER_FRAME
-  int timeToWait = MILLISECS_PER_FRAME - (SDL_GetTicks() - millisecsPreviousFrame);
-  if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME)
+  return frameLimiter.GetStats();
+}
+
+void Game::SetHeadless(bool isHeadless, int tickRate)
+{
+  this->isHeadless = isHeadless;
+  if (!isHeadless)
+  {
+    return;
+  }
+  if (tickRate > 0)
+  {
+    SetSimulationRate(tickRate);
+    SetFrameLimit(FRAME_LIMIT_TARGET, tickRate);
+  }
+  else
   {
-    // wait and give the hands to the OS to free some proc ressources
-    SDL_Delay(timeToWait);
+    SetFrameLimit(FRAME_LIMIT_UNCAPPED);
   }
+}
 
-  // The difference in ticks since the last frame, converted to seconds
-  double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+void Game::SetTickLimit(uint64_t numTicks)
+{
+  tickLimit = numTicks;
+}
 
-  // Store the current frame time
-  millisecsPreviousFrame = SDL_GetTicks();
+void Game::Tick()
+{
+  PROFILE_ZONE("Game::Tick");
 
   // Invoke all the systems that need to update
-  registry->GetSystem<MovementSystem>().Update(deltaTime);
+  registry->GetSystem<MovementSystem>().Update(fixedDeltaTime);
 
   // Update the registry to process the entities that are waiting to be created/deleted
   registry->Update();
+
+  numTicks++;
+  if (tickLimit > 0 && numTicks >= tickLimit)
+  {
+    isRunning = false;
+  }
+}
+
+void Game::ReportTickRate(bool isFinal)
+{
+  const Uint64 counter = SDL_GetPerformanceCounter();
+  const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+  if (isFinal)
+  {
+    const double seconds = (counter - startCounter) / frequency;
+    Logger::Logf("%llu ticks in %.2f s, %.0f ticks/s", static_cast<unsigned long long>(numTicks), seconds, numTicks / seconds);
+    return;
+  }
+
+  const double seconds = (counter - lastReportCounter) / frequency;
+  if (seconds >= TICK_RATE_REPORT_INTERVAL)
+  {
+    Logger::Logf("%.0f ticks/s", (numTicks - numTicksAtLastReport) / seconds);
+    lastReportCounter = counter;
+    numTicksAtLastReport = numTicks;
+  }
+}
+
+void Game::Update()
+{
+  PROFILE_ZONE("Game::Update");
+
+  // If we are too fast, wait for the start of the next frame, then get the time since the last one in seconds
+  const double frameTime = frameLimiter.WaitForNextFrame();
+
+  // Run as many fixed steps as the elapsed time allows, the rest waits for the next frame
+  accumulatedTime += frameTime;
+  int numSteps = 0;
+  while (isRunning && accumulatedTime >= fixedDeltaTime && numSteps < MAX_SIMULATION_STEPS_PER_FRAME)
+  {
+    Tick();
+    accumulatedTime -= fixedDeltaTime;
+    numSteps++;
+  }
+  if (accumulatedTime >= fixedDeltaTime)
+  {
+    // Too far behind to catch up, give up on the missed steps
+    accumulatedTime = std::fmod(accumulatedTime, fixedDeltaTime);
+  }
+
+  interpolationAlpha = accumulatedTime / fixedDeltaTime;
+}
+
+void Game::UpdateHeadless()
+{
+  // Nothing to interpolate without rendering, so exactly one step per frame
+  frameLimiter.WaitForNextFrame();
+  Tick();
+  ReportTickRate(false);
 }
 
 void Game::Render()
 {
+  PROFILE_ZONE("Game::Render");
+
   SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
   SDL_RenderClear(renderer);
 
+  tilemap.Render(renderer, *assetStore, camera);
+
   // Invode all the systems that need to render
-  registry->GetSystem<RenderSystem>().Update(renderer);
+  registry->GetSystem<RenderSystem>().Update(renderer, *assetStore, camera, interpolationAlpha);
 
-  SDL_RenderPresent(renderer);
+  // Drawn last, on top of the game
+  debugOverlay.Render(*registry, frameLimiter);
+
+  {
+    // Includes the wait for the vsync, if any
+    PROFILE_ZONE("SDL_RenderPresent");
+    SDL_RenderPresent(renderer);
+  }
 }
 
 void Game::Run()
 {
   Setup();
+
+  frameLimiter.Start();
+  startCounter = SDL_GetPerformanceCounter();
+  lastReportCounter = startCounter;
   while (isRunning)
   {
+    // The zones of the previous frame become the summary shown by the overlay
+    Profiler::EndFrame();
+    PROFILE_ZONE("Frame");
+    Logger::SetFrameNumber(++frameNumber);
     ProcessInput();
+    if (isHeadless)
+    {
+      UpdateHeadless();
+      continue;
+    }
     Update();
     Render();
   }
+  ReportTickRate(true);
 }
 
 void Game::Destroy()
 {
-  SDL_DestroyRenderer(renderer);
-  SDL_DestroyWindow(window);
+  const FrameStats stats = frameLimiter.GetStats();
+  Logger::Logf("Frame times over the last %d frames: mean %.2f ms, p99 %.2f ms, max %.2f ms",
+               stats.numFrames, stats.mean, stats.p99, stats.max);
+
+  debugOverlay.Destroy();
+  tilemap.Destroy();
+  assetStore->ClearAssets();
+  if (renderer)
+  {
+    SDL_DestroyRenderer(renderer);
+  }
+  if (window)
+  {
+    SDL_DestroyWindow(window);
+  }
   SDL_Quit();
 }
\ No newline at end of file
@@ -3,19 +3,57 @@
 #include <SDL_image.h>
 #include <glm/glm.hpp>
 #include "../ECS/ECS.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Tilemap/Tilemap.h"
+#include "FrameLimiter.h"
+#include "DebugOverlay.h"
 
 const int FPS = 144;
-const int MILLISECS_PER_FRAME = 1000 / FPS;
+
+// The simulation advances by fixed steps, whatever the frame rate
+const int DEFAULT_SIMULATION_RATE = 120;
+
+// Most simulation steps run in a single frame. When the game can't keep up
+// the time left over is dropped, instead of piling up steps frame after frame.
+const int MAX_SIMULATION_STEPS_PER_FRAME = 8;
+
+// How often the headless mode logs the number of ticks per second
+const double TICK_RATE_REPORT_INTERVAL = 1.0;
 
 class Game
 {
 private:
   bool isRunning;
-  int millisecsPreviousFrame = 0;
-  SDL_Window *window;     // Game window
-  SDL_Renderer *renderer; // Renderer who go inside the window
+  bool isHeadless = false;
+  FrameLimiter frameLimiter{FRAME_LIMIT_TARGET, FPS};
+
+  // Simulation time not consumed by a step yet, and the duration of a step
+  double accumulatedTime = 0.0;
+  double fixedDeltaTime = 1.0 / DEFAULT_SIMULATION_RATE;
+  // Fraction of a step left in the accumulator, used to interpolate the rendering
+  double interpolationAlpha = 0.0;
+
+  uint64_t frameNumber = 0; // Also given to the logger, see LOG_TIMESTAMP_FRAME
+
+  // Simulation steps run so far, and how many to run before stopping (0 for no limit)
+  uint64_t numTicks = 0;
+  uint64_t tickLimit = 0;
+  Uint64 startCounter = 0;
+  Uint64 lastReportCounter = 0;
+  uint64_t numTicksAtLastReport = 0;
+
+  SDL_Window *window = nullptr;     // Game window
+  SDL_Renderer *renderer = nullptr; // Renderer who go inside the window
 
   std::unique_ptr<Registry> registry;
+  std::unique_ptr<AssetStore> assetStore;
+  Tilemap tilemap;
+
+  // Part of the world shown in the window, in pixels
+  SDL_Rect camera = {0, 0, 0, 0};
+
+  // Performance overlay, toggled with F1
+  DebugOverlay debugOverlay;
 
 public:
   Game();
@@ -25,9 +63,25 @@ public:
   void Setup();
   void ProcessInput();
   void Update();
+  void UpdateHeadless();
+  void Tick();
+  void ReportTickRate(bool isFinal);
   void Render();
   void Destroy();
 
+  // Number of simulation steps per second
+  void SetSimulationRate(int stepsPerSecond);
+  // How the frames are paced, FPS frames per second by default
+  void SetFrameLimit(FrameLimiterMode mode, double targetFrameRate = FPS);
+  FrameStats GetFrameStats() const;
+
+  // Runs the simulation without window, renderer nor audio, e.g. on a server or to
+  // measure its throughput: each frame is a single step, run tickRate times per
+  // second or as fast as possible when tickRate is 0. Call it before Initialize.
+  void SetHeadless(bool isHeadless, int tickRate = 0);
+  // Stops the game after this many simulation steps, 0 for no limit
+  void SetTickLimit(uint64_t numTicks);
+
   int windowWidth;
   int windowHeight;
 };
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "LogFormat.h"
+#include <algorithm>
+#include <ctime>
+#include <stdio.h>
+
+void LogArgumentEncoder::AppendString(std::string_view text)
+{
+  const size_t header = 1 + sizeof(uint16_t);
+  if (length + header + text.size() <= capacity)
+  {
+    const uint16_t textLength = static_cast<uint16_t>(text.size());
+    buffer[length] = static_cast<char>(LogArgumentType::String);
+    std::memcpy(buffer + length + 1, &textLength, sizeof(uint16_t));
+    std::memcpy(buffer + length + header, text.data(), textLength);
+    length += header + textLength;
+    return;
+  }
+
+  // Too long for the record, rather than truncating it pay for a copy on the heap
+  const size_t heapSize = 1 + sizeof(uint64_t) + sizeof(uint32_t);
+  if (length + heapSize > capacity)
+  {
+    length = capacity;
+    return;
+  }
+  char *copy = new char[text.size()];
+  std::memcpy(copy, text.data(), text.size());
+  const uint64_t address = reinterpret_cast<uintptr_t>(copy);
+  const uint32_t textLength = static_cast<uint32_t>(text.size());
+  buffer[length] = static_cast<char>(LogArgumentType::HeapString);
+  std::memcpy(buffer + length + 1, &address, sizeof(address));
+  std::memcpy(buffer + length + 1 + sizeof(address), &textLength, sizeof(textLength));
+  length += heapSize;
+}
+
+// Size of the encoded argument, 0 if it is corrupted or goes past the end
+static size_t GetEncodedSize(const char *argument, const char *end)
+{
+  size_t size = 0;
+  switch (static_cast<LogArgumentType>(*argument))
+  {
+  case LogArgumentType::Int:
+  case LogArgumentType::UnsignedInt:
+  case LogArgumentType::Double:
+  case LogArgumentType::Pointer:
+    size = 1 + sizeof(uint64_t);
+    break;
+  case LogArgumentType::HeapString:
+    size = 1 + sizeof(uint64_t) + sizeof(uint32_t);
+    break;
+  case LogArgumentType::String:
+  {
+    uint16_t length = 0;
+    if (end - argument >= static_cast<std::ptrdiff_t>(1 + sizeof(length)))
+    {
+      std::memcpy(&length, argument + 1, sizeof(length));
+    }
+    size = 1 + sizeof(length) + length;
+    break;
+  }
+  case LogArgumentType::LongString:
+  {
+    uint32_t length = 0;
+    if (end - argument >= static_cast<std::ptrdiff_t>(1 + sizeof(length)))
+    {
+      std::memcpy(&length, argument + 1, sizeof(length));
+    }
+    size = 1 + sizeof(length) + length;
+    break;
+  }
+  default:
+    return 0;
+  }
+  return size <= static_cast<size_t>(end - argument) ? size : 0;
+}
+
+bool ExpandLogArguments(const char *arguments, size_t length, std::string &expanded)
+{
+  const char *end = arguments + length;
+  const char *argument = arguments;
+  size_t size;
+  while (argument < end && static_cast<LogArgumentType>(*argument) != LogArgumentType::HeapString &&
+         (size = GetEncodedSize(argument, end)) != 0)
+  {
+    argument += size;
+  }
+  if (argument == end || static_cast<LogArgumentType>(*argument) != LogArgumentType::HeapString)
+  {
+    return false;
+  }
+
+  expanded.assign(arguments, argument - arguments);
+  while (argument < end)
+  {
+    size = GetEncodedSize(argument, end);
+    if (size == 0)
+    {
+      // Leave the corrupted arguments to the formatter
+      expanded.append(argument, end - argument);
+      break;
+    }
+    if (static_cast<LogArgumentType>(*argument) == LogArgumentType::HeapString)
+    {
+      uint64_t address;
+      uint32_t textLength;
+      std::memcpy(&address, argument + 1, sizeof(address));
+      std::memcpy(&textLength, argument + 1 + sizeof(address), sizeof(textLength));
+      char *text = reinterpret_cast<char *>(static_cast<uintptr_t>(address));
+      expanded += static_cast<char>(LogArgumentType::LongString);
+      expanded.append(reinterpret_cast<const char *>(&textLength), sizeof(textLength));
+      expanded.append(text, textLength);
+      delete[] text;
+    }
+    else
+    {
+      expanded.append(argument, size);
+    }
+    argument += size;
+  }
+  return true;
+}
+
+// Formats one argument with its conversion specification,
+// the length modifiers are replaced to match how the argument was stored
+static void FormatArgument(std::string spec, char conversion, const char *&arguments, const char *end, std::string &output)
+{
+  if (arguments >= end)
+  {
+    output += spec;
+    return;
+  }
+
+  spec.pop_back();
+  while (!spec.empty() && std::string("hljztL").find(spec.back()) != std::string::npos)
+  {
+    spec.pop_back();
+  }
+
+  if (GetEncodedSize(arguments, end) == 0)
+  {
+    // Corrupted arguments, stop decoding them
+    arguments = end;
+    output += "<?>";
+    return;
+  }
+  const auto type = static_cast<LogArgumentType>(*arguments++);
+  char text[512];
+  int textLength = 0;
+
+  switch (type)
+  {
+  case LogArgumentType::Int:
+  case LogArgumentType::UnsignedInt:
+  case LogArgumentType::Pointer:
+  {
+    uint64_t value;
+    std::memcpy(&value, arguments, sizeof(value));
+    arguments += sizeof(value);
+    if (conversion == 'f' || conversion == 'e' || conversion == 'g')
+    {
+      const double number = (type == LogArgumentType::Int) ? static_cast<double>(static_cast<int64_t>(value)) : static_cast<double>(value);
+      textLength = snprintf(text, sizeof(text), (spec + conversion).c_str(), number);
+    }
+    else if (conversion == 'c')
+    {
+      textLength = snprintf(text, sizeof(text), (spec + 'c').c_str(), static_cast<int>(value));
+    }
+    else if (conversion == 'p')
+    {
+      textLength = snprintf(text, sizeof(text), (spec + conversion).c_str(), reinterpret_cast<void *>(static_cast<uintptr_t>(value)));
+    }
+    else if (conversion == 's')
+    {
+      const std::string number = (type == LogArgumentType::Int) ? std::to_string(static_cast<int64_t>(value)) : std::to_string(value);
+      textLength = snprintf(text, sizeof(text), (spec + 's').c_str(), number.c_str());
+    }
+    else
+    {
+      textLength = snprintf(text, sizeof(text), (spec + "ll" + conversion).c_str(), value);
+    }
+    break;
+  }
+  case LogArgumentType::Double:
+  {
+    double value;
+    std::memcpy(&value, arguments, sizeof(value));
+    arguments += sizeof(value);
+    if (conversion == 'd' || conversion == 'i')
+    {
+      textLength = snprintf(text, sizeof(text), (spec + "lld").c_str(), static_cast<long long>(value));
+    }
+    else if (conversion == 's')
+    {
+      textLength = snprintf(text, sizeof(text), (spec + 's').c_str(), std::to_string(value).c_str());
+    }
+    else
+    {
+      textLength = snprintf(text, sizeof(text), (spec + conversion).c_str(), value);
+    }
+    break;
+  }
+  case LogArgumentType::String:
+  case LogArgumentType::LongString:
+  {
+    size_t length;
+    if (type == LogArgumentType::String)
+    {
+      uint16_t shortLength;
+      std::memcpy(&shortLength, arguments, sizeof(shortLength));
+      arguments += sizeof(shortLength);
+      length = shortLength;
+    }
+    else
+    {
+      uint32_t longLength;
+      std::memcpy(&longLength, arguments, sizeof(longLength));
+      arguments += sizeof(longLength);
+      length = longLength;
+    }
+    const std::string value(arguments, std::min<size_t>(length, end - arguments));
+    arguments += length;
+    textLength = snprintf(text, sizeof(text), (spec + 's').c_str(), value.c_str());
+    // Long strings don't fit in the scratch buffer, copy them as they are
+    if (textLength >= static_cast<int>(sizeof(text)))
+    {
+      output += value;
+      return;
+    }
+    break;
+  }
+  default:
+    // Heap strings left unexpanded, stop decoding them
+    arguments = end;
+    output += "<?>";
+    return;
+  }
+
+  if (textLength > 0)
+  {
+    output.append(text, std::min<size_t>(textLength, sizeof(text) - 1));
+  }
+}
+
+std::string FormatLogArguments(const char *format, const char *arguments, size_t length)
+{
+  std::string output;
+  const char *end = arguments + length;
+
+  for (const char *character = format; *character; character++)
+  {
+    if (*character != '%')
+    {
+      output += *character;
+      continue;
+    }
+    if (character[1] == '%')
+    {
+      output += '%';
+      character++;
+      continue;
+    }
+
+    // Gather the whole conversion specification, e.g. %-8.3f
+    const char *specStart = character++;
+    while (*character && std::string("diouxXeEfFgGaAcsp").find(*character) == std::string::npos)
+    {
+      character++;
+    }
+    if (!*character)
+    {
+      output += specStart;
+      break;
+    }
+    FormatArgument(std::string(specStart, character + 1), *character, arguments, end, output);
+  }
+
+  return output;
+}
+
+void LogTimestampCache::Append(std::string &output, std::chrono::system_clock::time_point time)
+{
+  const auto sinceEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch());
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch);
+  // Round towards the past for the times before the epoch as well
+  const bool isBeforeSecond = sinceEpoch < seconds;
+  const std::time_t second = seconds.count() - (isBeforeSecond ? 1 : 0);
+  const int milliseconds = static_cast<int>((sinceEpoch - seconds).count() + (isBeforeSecond ? 1000 : 0));
+
+  if (second != cachedSecond)
+  {
+    std::tm localTime;
+    localtime_r(&second, &localTime);
+    cachedLength = std::strftime(cachedText, sizeof(cachedText), "%d-%b-%Y %H:%M:%S", &localTime);
+    cachedSecond = second;
+  }
+
+  const char subSecond[4] = {'.', static_cast<char>('0' + milliseconds / 100),
+                             static_cast<char>('0' + milliseconds / 10 % 10), static_cast<char>('0' + milliseconds % 10)};
+  output.append(cachedText, cachedLength);
+  output.append(subSecond, sizeof(subSecond));
+}
+
+std::string DateTimeToString(std::chrono::system_clock::time_point time)
+{
+  thread_local LogTimestampCache cache;
+  std::string output;
+  cache.Append(output, time);
+  return output;
+}
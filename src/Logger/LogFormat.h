@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Deferred log formatting:
+// the calling thread only captures a pointer to the format string (which must
+// be a string literal, or outlive the logger) and the raw bytes of the
+// arguments. The writer thread, or the offline log decoder, turns them into
+// text later on with printf-like rules.
+
+// Every argument is stored as a one byte tag followed by its raw value
+enum class LogArgumentType : unsigned char
+{
+  Int,         // int64_t
+  UnsignedInt, // uint64_t
+  Double,      // double
+  String,      // uint16_t length, then the characters
+  Pointer,     // uint64_t
+  HeapString,  // uint64_t address of a copy allocated with new[], uint32_t length.
+               // Only in the log queue, the writer turns it into a LongString.
+  LongString   // uint32_t length, then the characters
+};
+
+// Appends the arguments of a log call to a fixed-size buffer.
+// A string too long for the room left is copied on the heap and only its
+// address is stored, the arguments that don't fit at all are left out.
+class LogArgumentEncoder
+{
+private:
+  char *buffer;
+  size_t capacity;
+  size_t length = 0;
+
+  template <typename TValue>
+  void Append(LogArgumentType type, TValue value)
+  {
+    if (length + 1 + sizeof(TValue) > capacity)
+    {
+      length = capacity;
+      return;
+    }
+    buffer[length] = static_cast<char>(type);
+    std::memcpy(buffer + length + 1, &value, sizeof(TValue));
+    length += 1 + sizeof(TValue);
+  }
+
+  void AppendString(std::string_view text);
+
+public:
+  LogArgumentEncoder(char *buffer, size_t capacity) : buffer(buffer), capacity(capacity) {}
+
+  size_t GetLength() const { return length; }
+
+  template <typename T>
+  void Encode(const T &value)
+  {
+    if constexpr (std::is_same_v<T, bool>)
+    {
+      Append(LogArgumentType::Int, static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_enum_v<T> || (std::is_integral_v<T> && std::is_signed_v<T>))
+    {
+      Append(LogArgumentType::Int, static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+      Append(LogArgumentType::UnsignedInt, static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+      Append(LogArgumentType::Double, static_cast<double>(value));
+    }
+    else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+    {
+      AppendString(std::string_view(value));
+    }
+    else if constexpr (std::is_pointer_v<T>)
+    {
+      Append(LogArgumentType::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+    else
+    {
+      static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+    }
+  }
+};
+
+// Replaces the heap strings of encoded arguments by LongStrings in expanded,
+// and frees their copies. Returns false, leaving expanded alone, when there is none.
+bool ExpandLogArguments(const char *arguments, size_t length, std::string &expanded);
+
+// Applies a printf-like format string to encoded arguments, without heap strings
+std::string FormatLogArguments(const char *format, const char *arguments, size_t length);
+
+// Formats log timestamps such as "16-Oct-2026 17:06:32.125".
+// localtime and strftime only run when the second changes, the rest of the time
+// the cached date and time are copied and the milliseconds appended by hand.
+// Not thread safe: every thread formatting timestamps keeps its own cache.
+class LogTimestampCache
+{
+private:
+  std::time_t cachedSecond = -1;
+  char cachedText[32];
+  size_t cachedLength = 0;
+
+public:
+  void Append(std::string &output, std::chrono::system_clock::time_point time);
+};
+
+// Uses a cache local to the calling thread
+std::string DateTimeToString(std::chrono::system_clock::time_point time);
+
+// Binary log files start with this magic value, followed by entries:
+// - LOG_BINARY_FORMAT: uint32_t format id, uint16_t length, the format string
+// - LOG_BINARY_RECORD: uint8_t log type, int64_t nanoseconds since the epoch,
+//   uint32_t format id, uint32_t length, the encoded arguments
+// A format is defined once, before the first record using it.
+// All the values are stored in the byte order of the machine writing the log.
+const char LOG_BINARY_MAGIC[8] = {'G', 'E', 'L', 'O', 'G', 'B', 'I', '2'};
+const char LOG_BINARY_FORMAT = 'F';
+const char LOG_BINARY_RECORD = 'R';
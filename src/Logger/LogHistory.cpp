@@ -0,0 +1,114 @@
+#include "LogHistory.h"
+#include <algorithm>
+#include <cstring>
+
+LogHistory::LogHistory() : slots(LOG_HISTORY_CAPACITY), text(LOG_HISTORY_TEXT_SIZE)
+{
+}
+
+void LogHistory::EvictOldest()
+{
+  numEntriesOfType[slots[first].type]--;
+  first = (first + 1) % slots.size();
+  numEntries--;
+}
+
+void LogHistory::Add(LogType type, std::chrono::system_clock::time_point time, uint64_t frame, const char *message, size_t length)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const bool isTruncated = length > LOG_HISTORY_MAX_MESSAGE_LENGTH;
+  const size_t markLength = sizeof(LOG_HISTORY_TRUNCATION_MARK) - 1;
+  const size_t keptLength = isTruncated ? LOG_HISTORY_MAX_MESSAGE_LENGTH - markLength : length;
+  length = std::min(length, LOG_HISTORY_MAX_MESSAGE_LENGTH);
+  const size_t size = length + 1;
+
+  // The live text always runs from the oldest entry up to textOffset, wrapping around
+  // the end of the arena, so the entries to evict are always the oldest ones
+  if (textOffset + size > text.size())
+  {
+    // The text doesn't fit before the end of the arena: drop the entries left there and wrap
+    while (numEntries > 0 && slots[first].textOffset >= textOffset)
+    {
+      EvictOldest();
+    }
+    textOffset = 0;
+  }
+  while (numEntries > 0 && slots[first].textOffset >= textOffset && slots[first].textOffset < textOffset + size)
+  {
+    EvictOldest();
+  }
+  if (numEntries == slots.size())
+  {
+    EvictOldest();
+  }
+
+  Slot &slot = slots[(first + numEntries) % slots.size()];
+  slot.type = type;
+  slot.time = time;
+  slot.frame = frame;
+  slot.textOffset = textOffset;
+  slot.length = length;
+  std::memcpy(&text[textOffset], message, keptLength);
+  if (isTruncated)
+  {
+    std::memcpy(&text[textOffset + keptLength], LOG_HISTORY_TRUNCATION_MARK, markLength);
+  }
+  text[textOffset + length] = '\0';
+
+  textOffset += size;
+  numEntries++;
+  numEntriesOfType[type]++;
+}
+
+void LogHistory::Clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  first = 0;
+  numEntries = 0;
+  textOffset = 0;
+  std::fill(std::begin(numEntriesOfType), std::end(numEntriesOfType), 0);
+}
+
+size_t LogHistory::CopyEntries(size_t begin, size_t end, unsigned int typeMask, std::vector<LogHistoryMessage> &messages) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  size_t numMatching = 0;
+  size_t numCopied = 0;
+  for (size_t i = 0; i < numEntries; i++)
+  {
+    const Slot &slot = slots[(first + i) % slots.size()];
+    if (!(typeMask & LogTypeMask(slot.type)))
+    {
+      continue;
+    }
+    if (numMatching >= begin && numMatching < end)
+    {
+      if (numCopied == messages.size())
+      {
+        messages.emplace_back();
+      }
+      LogHistoryMessage &message = messages[numCopied++];
+      message.type = slot.type;
+      message.time = slot.time;
+      message.frame = slot.frame;
+      message.message.assign(&text[slot.textOffset], slot.length);
+    }
+    numMatching++;
+  }
+  messages.resize(numCopied);
+  return numMatching;
+}
+
+size_t LogHistory::GetNumEntries() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return numEntries;
+}
+
+size_t LogHistory::GetNumEntries(LogType type) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return numEntriesOfType[type];
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Logger.h"
+
+// Most messages kept in the history, the oldest ones are evicted first
+const size_t LOG_HISTORY_CAPACITY = 4096;
+
+// Size of the arena holding the text of the messages
+const size_t LOG_HISTORY_TEXT_SIZE = 512 * 1024;
+
+// Longer messages are truncated when they are added to the history, and end with LOG_HISTORY_TRUNCATION_MARK
+const size_t LOG_HISTORY_MAX_MESSAGE_LENGTH = 1024;
+const char LOG_HISTORY_TRUNCATION_MARK[] = "...[truncated]";
+
+// Mask of the log types to visit, e.g. LogTypeMask(LOG_WARNING) | LogTypeMask(LOG_ERROR)
+inline unsigned int LogTypeMask(LogType type) { return 1u << type; }
+const unsigned int LOG_TYPE_MASK_ALL = ~0u;
+
+struct LogHistoryEntry
+{
+  LogType type;
+  std::chrono::system_clock::time_point time;
+  uint64_t frame;
+  // Null terminated, only valid during the ForEach callback
+  const char *message;
+  size_t length;
+};
+
+// Copy of an entry, made by LogHistory::CopyEntries
+struct LogHistoryMessage
+{
+  LogType type;
+  std::chrono::system_clock::time_point time;
+  uint64_t frame;
+  std::string message;
+};
+
+// Fixed-size circular history of the last messages logged, for the debug console.
+// The entries and their text live in two rings allocated once, so the memory
+// used doesn't depend on how long the game has been running: a new message
+// evicts the oldest entries until both its entry and its text fit.
+// Written by the log writer thread and read from any thread, under a mutex.
+class LogHistory
+{
+private:
+  struct Slot
+  {
+    LogType type;
+    std::chrono::system_clock::time_point time;
+    uint64_t frame;
+    size_t textOffset;
+    size_t length;
+  };
+
+  mutable std::mutex mutex;
+  std::vector<Slot> slots;
+  std::vector<char> text;
+
+  // Index of the oldest slot, and offset where the next message text goes
+  size_t first = 0;
+  size_t numEntries = 0;
+  size_t textOffset = 0;
+  size_t numEntriesOfType[LOG_ERROR + 1] = {};
+
+  void EvictOldest();
+
+public:
+  LogHistory();
+
+  void Add(LogType type, std::chrono::system_clock::time_point time, uint64_t frame, const char *message, size_t length);
+  void Clear();
+
+  // Calls the function with each entry of a type in the mask, from the oldest to the newest.
+  // The history is locked meanwhile, so the function must not log.
+  template <typename TFunction>
+  void ForEach(TFunction function, unsigned int typeMask = LOG_TYPE_MASK_ALL) const;
+
+  // Copies the entries numbered [begin, end) among those of a type in the mask, from the oldest,
+  // and returns how many entries of these types there are. Both come from a single lock, so the
+  // caller can draw the visible part of a long list without holding the history meanwhile.
+  // The copies replace the content of messages.
+  size_t CopyEntries(size_t begin, size_t end, unsigned int typeMask, std::vector<LogHistoryMessage> &messages) const;
+
+  size_t GetNumEntries() const;
+  size_t GetNumEntries(LogType type) const;
+};
+
+template <typename TFunction>
+void LogHistory::ForEach(TFunction function, unsigned int typeMask) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < numEntries; i++)
+  {
+    const Slot &slot = slots[(first + i) % slots.size()];
+    if (typeMask & LogTypeMask(slot.type))
+    {
+      function(LogHistoryEntry{slot.type, slot.time, slot.frame, &text[slot.textOffset], slot.length});
+    }
+  }
+}
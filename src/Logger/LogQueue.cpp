@@ -0,0 +1,73 @@
+#include "LogQueue.h"
+
+LogQueue::LogQueue(size_t capacity) : slots(new Slot[capacity]), mask(capacity - 1)
+{
+  for (size_t i = 0; i < capacity; i++)
+  {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LogQueue::Push(LogType type, uint64_t frame, const char *format, Logger::EncodeFunction encode, const void *arguments)
+{
+  // Claim a slot by moving the enqueue position forward
+  size_t position = enqueuePosition.load(std::memory_order_relaxed);
+  Slot *slot;
+  while (true)
+  {
+    slot = &slots[position & mask];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+    if (difference == 0)
+    {
+      // The slot is free, try to take it before another producer does
+      if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      // The consumer hasn't freed this slot yet: the queue is full
+      numDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      // Another producer took the slot, try again with the latest position
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  LogRecord &record = slot->record;
+  record.type = type;
+  record.time = Clock::Now();
+  record.frame = frame;
+  record.format = format;
+  record.length = encode(record.arguments, LOG_RECORD_ARGUMENTS_SIZE, arguments);
+
+  // Hand the slot over to the consumer
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool LogQueue::Pop(LogRecord &record)
+{
+  const size_t position = dequeuePosition.load(std::memory_order_relaxed);
+  Slot &slot = slots[position & mask];
+  const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+  // The producer that claimed this slot hasn't finished writing it yet
+  if (sequence != position + 1)
+  {
+    return false;
+  }
+
+  record = slot.record;
+
+  // Give the slot back to the producers for the next lap around the ring
+  slot.sequence.store(position + mask + 1, std::memory_order_release);
+  dequeuePosition.store(position + 1, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "../Clock/Clock.h"
+#include "Logger.h"
+
+// Room left in a record for the encoded arguments, the ones that don't fit are left out.
+// Keeps the queue slots at 256 bytes, longer strings are moved to the heap, see LogArgumentEncoder.
+const size_t LOG_RECORD_ARGUMENTS_SIZE = 216;
+
+// A log call as it travels from the calling thread to the writer thread:
+// the format string is only referenced, and the arguments are kept as raw
+// bytes until the writer formats them
+struct LogRecord
+{
+  LogType type;
+  int64_t time; // On Clock, converted to the system clock by the writer thread
+  uint64_t frame;
+  const char *format;
+  unsigned int length;
+  char arguments[LOG_RECORD_ARGUMENTS_SIZE];
+};
+
+// Bounded lock-free multi-producer single-consumer queue of log records.
+// Every slot carries a sequence number telling whether it is free for the
+// producers or ready for the consumer, so a producer only pays for one atomic
+// increment and for encoding its arguments straight into the slot it claimed,
+// and never blocks: when the queue is full the record is dropped and counted.
+class LogQueue
+{
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t mask;
+
+  // Keep the positions on separate cache lines so producers and consumer don't contend
+  alignas(64) std::atomic<size_t> enqueuePosition{0};
+  alignas(64) std::atomic<size_t> dequeuePosition{0};
+  alignas(64) std::atomic<size_t> numDropped{0};
+
+public:
+  // The capacity must be a power of two
+  LogQueue(size_t capacity);
+
+  // Can be called from any thread, returns false if the record was dropped.
+  // encode writes the arguments in the given buffer and returns their length.
+  bool Push(LogType type, uint64_t frame, const char *format, Logger::EncodeFunction encode, const void *arguments);
+
+  // Must only be called from the consumer thread, returns false if the queue is empty
+  bool Pop(LogRecord &record);
+
+  // Number of records pushed (or popped) since the queue was created
+  size_t GetEnqueuePosition() const { return enqueuePosition.load(std::memory_order_acquire); }
+  size_t GetDequeuePosition() const { return dequeuePosition.load(std::memory_order_acquire); }
+  size_t GetNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+};
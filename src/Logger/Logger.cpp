@@ -1,36 +1,449 @@
 #include "Logger.h"
+#include "LogHistory.h"
+#include "LogQueue.h"
+#include <atomic>
 #include <chrono>
-#include <ctime>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <stdio.h>
+#include <thread>
+#include <unordered_map>
 
-std::vector<LogEntry> Logger::messages;
+// Number of records the queue can hold before dropping messages
+const size_t LOG_QUEUE_CAPACITY = 8192;
 
-std::string CurrentDateTimeToString()
+// Most records written at once by the writer thread
+const size_t LOG_BATCH_SIZE = 512;
+
+// How long the writer thread sleeps when there is nothing to write
+const std::chrono::milliseconds LOG_WRITER_IDLE_TIME(1);
+
+// Number of pending records past which a log call wakes the sleeping writer thread
+// right away, instead of letting a burst fill the queue before the sleep ends
+const size_t LOG_WRITER_WAKE_THRESHOLD = LOG_QUEUE_CAPACITY / 4;
+
+// Converts the Clock time of the records to the system clock.
+// Both clocks are read together before each batch: the records being at most
+// a batch old, an error on the length of a tick barely moves them.
+class LogClockConverter
+{
+private:
+  int64_t batchTicks = 0;
+  std::chrono::system_clock::time_point batchTime;
+  double nanosecondsPerTick = 1.0;
+
+public:
+  LogClockConverter()
+  {
+    Clock::Calibrate();
+    Update();
+  }
+
+  void Update()
+  {
+    batchTicks = Clock::Now();
+    batchTime = std::chrono::system_clock::now();
+    nanosecondsPerTick = Clock::GetNanosecondsPerTick();
+  }
+
+  std::chrono::system_clock::time_point ToSystemTime(int64_t ticks) const
+  {
+    const std::chrono::nanoseconds age(static_cast<int64_t>((batchTicks - ticks) * nanosecondsPerTick));
+    return batchTime - std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+  }
+};
+
+// Owns the queue of pending records and the background thread writing them out
+class LogWriter
+{
+private:
+  LogQueue queue;
+  std::thread thread;
+  std::atomic<bool> isStopping{false};
+
+  // The log calls only take the mutex to wake the writer, when it sleeps and the queue fills up
+  std::mutex wakeMutex;
+  std::condition_variable wakeCondition;
+  std::atomic<bool> isSleeping{false};
+
+  // Outputs, locked by the writer thread while it writes a batch
+  std::mutex outputMutex;
+  bool isConsoleEnabled = true;
+  LogTimestampMode timestampMode = LOG_TIMESTAMP_DATE_TIME;
+  FILE *file = nullptr;
+  FILE *binaryFile = nullptr;
+
+  // Only used by the writer thread, the strings are reused to avoid allocating for each record
+  LogClockConverter clock;
+  LogTimestampCache timestampCache;
+  std::string lineText;
+  std::string expandedArguments;
+
+  // Id of each format string already defined in the binary file
+  std::unordered_map<const char *, uint32_t> binaryFormatIds;
+
+  // Number of records written out so far
+  std::atomic<size_t> numWritten{0};
+  size_t numDroppedReported = 0;
+
+  void Run();
+  void WriteBatch(std::string &consoleText, std::string &fileText, std::string &binaryData);
+  void Add(const LogRecord &record, std::string &consoleText, std::string &fileText, std::string &binaryData);
+  void Format(const LogRecord &record, std::chrono::system_clock::time_point time, const char *arguments, size_t length,
+              std::string &consoleText, std::string &fileText);
+  void Encode(const LogRecord &record, std::chrono::system_clock::time_point time, const char *arguments, size_t length,
+              std::string &binaryData);
+
+public:
+  LogWriter();
+  ~LogWriter();
+
+  void Push(LogType type, uint64_t frame, const char *format, Logger::EncodeFunction encode, const void *arguments);
+  void Flush();
+  void SetConsoleOutput(bool isEnabled);
+  void SetFileOutput(const std::string &path);
+  void SetBinaryFileOutput(const std::string &path);
+  void SetTimestampMode(LogTimestampMode mode);
+  size_t GetNumDropped() const { return queue.GetNumDropped(); }
+};
+
+// Set once the writer is destroyed, so that messages logged during the
+// static destruction are still written, synchronously
+static std::atomic<bool> isWriterDestroyed{false};
+
+// Frame number recorded by the messages
+static std::atomic<uint64_t> frameNumber{0};
+
+// Declared before the writer so that it outlives the writer thread
+static LogHistory history;
+
+static LogWriter writer;
+
+LogWriter::LogWriter() : queue(LOG_QUEUE_CAPACITY)
 {
-  std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-  std::string output(30, '\0');
-  std::strftime(&output[0], output.size(), "%d-%b-%Y %H:%M:%S", std::localtime(&now));
-  return output;
+  thread = std::thread(&LogWriter::Run, this);
 }
 
-void Logger::Log(const std::string &message)
+LogWriter::~LogWriter()
 {
-  LogEntry logEntry;
-  logEntry.type = LOG_INFO;
+  isStopping = true;
+  thread.join();
+  isWriterDestroyed = true;
 
-  logEntry.message = "LOG: [" + CurrentDateTimeToString() + "]: " + message;
-  std::cout << "\x1B[32m" << logEntry.message << "\033[0m" << std::endl;
+  if (file)
+  {
+    fclose(file);
+  }
+  if (binaryFile)
+  {
+    fclose(binaryFile);
+  }
+}
+
+void LogWriter::Add(const LogRecord &record, std::string &consoleText, std::string &fileText, std::string &binaryData)
+{
+  // The long strings are only moved back from the heap here
+  const char *arguments = record.arguments;
+  size_t length = record.length;
+  if (ExpandLogArguments(record.arguments, record.length, expandedArguments))
+  {
+    arguments = expandedArguments.data();
+    length = expandedArguments.size();
+  }
 
-  messages.push_back(logEntry);
+  const std::chrono::system_clock::time_point time = clock.ToSystemTime(record.time);
+  Format(record, time, arguments, length, consoleText, fileText);
+  if (binaryFile)
+  {
+    Encode(record, time, arguments, length, binaryData);
+  }
+}
+
+void LogWriter::Format(const LogRecord &record, std::chrono::system_clock::time_point time, const char *arguments, size_t length,
+                       std::string &consoleText, std::string &fileText)
+{
+  const std::string message = FormatLogArguments(record.format, arguments, length);
+  history.Add(record.type, time, record.frame, message.data(), message.size());
+
+  if (!isConsoleEnabled && !file)
+  {
+    return;
+  }
+  lineText = (record.type == LOG_ERROR) ? "ERR: [" : "LOG: [";
+  if (timestampMode == LOG_TIMESTAMP_FRAME)
+  {
+    lineText += "frame " + std::to_string(record.frame);
+  }
+  else
+  {
+    timestampCache.Append(lineText, time);
+  }
+  lineText += "]: ";
+  lineText += message;
+
+  if (isConsoleEnabled)
+  {
+    consoleText += (record.type == LOG_ERROR) ? "\x1B[91m" : "\x1B[32m";
+    consoleText += lineText;
+    consoleText += "\033[0m\n";
+  }
+  if (file)
+  {
+    fileText += lineText;
+    fileText += '\n';
+  }
+}
+
+template <typename TValue>
+static void AppendBinary(std::string &binaryData, TValue value)
+{
+  binaryData.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void LogWriter::Encode(const LogRecord &record, std::chrono::system_clock::time_point time, const char *arguments, size_t length,
+                       std::string &binaryData)
+{
+  // Define the format string the first time a record uses it
+  auto formatId = binaryFormatIds.find(record.format);
+  if (formatId == binaryFormatIds.end())
+  {
+    formatId = binaryFormatIds.emplace(record.format, binaryFormatIds.size()).first;
+    const uint16_t formatLength = std::strlen(record.format);
+    binaryData += LOG_BINARY_FORMAT;
+    AppendBinary(binaryData, formatId->second);
+    AppendBinary(binaryData, formatLength);
+    binaryData.append(record.format, formatLength);
+  }
+
+  const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  binaryData += LOG_BINARY_RECORD;
+  AppendBinary(binaryData, static_cast<uint8_t>(record.type));
+  AppendBinary(binaryData, nanoseconds);
+  AppendBinary(binaryData, formatId->second);
+  AppendBinary(binaryData, static_cast<uint32_t>(length));
+  binaryData.append(arguments, length);
+}
+
+void LogWriter::WriteBatch(std::string &consoleText, std::string &fileText, std::string &binaryData)
+{
+  if (isConsoleEnabled && !consoleText.empty())
+  {
+    fwrite(consoleText.data(), 1, consoleText.size(), stdout);
+    fflush(stdout);
+  }
+  if (file && !fileText.empty())
+  {
+    fwrite(fileText.data(), 1, fileText.size(), file);
+    fflush(file);
+  }
+  if (binaryFile && !binaryData.empty())
+  {
+    fwrite(binaryData.data(), 1, binaryData.size(), binaryFile);
+    fflush(binaryFile);
+  }
+  consoleText.clear();
+  fileText.clear();
+  binaryData.clear();
+}
+
+void LogWriter::Run()
+{
+  LogRecord record;
+  std::string consoleText;
+  std::string fileText;
+  std::string binaryData;
+
+  while (true)
+  {
+    std::unique_lock<std::mutex> lock(outputMutex);
+
+    // Drain the queue in batches, so the outputs are flushed once per batch instead of once per line
+    clock.Update();
+    size_t numRecords = 0;
+    while (numRecords < LOG_BATCH_SIZE && queue.Pop(record))
+    {
+      Add(record, consoleText, fileText, binaryData);
+      numRecords++;
+    }
+
+    const size_t numDropped = queue.GetNumDropped();
+    if (numDropped != numDroppedReported)
+    {
+      // Report the loss like any other record
+      const std::string message = std::to_string(numDropped - numDroppedReported) + " log messages were dropped, the log queue was full";
+      LogArgumentEncoder encoder(record.arguments, LOG_RECORD_ARGUMENTS_SIZE);
+      encoder.Encode(message);
+      record.type = LOG_ERROR;
+      record.time = Clock::Now();
+      record.frame = frameNumber.load(std::memory_order_relaxed);
+      record.format = "%s";
+      record.length = encoder.GetLength();
+
+      Add(record, consoleText, fileText, binaryData);
+      numDroppedReported = numDropped;
+    }
+
+    WriteBatch(consoleText, fileText, binaryData);
+    numWritten.fetch_add(numRecords, std::memory_order_release);
+    lock.unlock();
+
+    if (numRecords == 0)
+    {
+      // Only stop once everything logged before the shutdown has been written
+      if (isStopping)
+      {
+        return;
+      }
+      std::unique_lock<std::mutex> wakeLock(wakeMutex);
+      isSleeping = true;
+      wakeCondition.wait_for(wakeLock, LOG_WRITER_IDLE_TIME, [this]()
+                             { return !isSleeping || queue.GetEnqueuePosition() - queue.GetDequeuePosition() >= LOG_WRITER_WAKE_THRESHOLD; });
+      isSleeping = false;
+    }
+  }
+}
+
+void LogWriter::Push(LogType type, uint64_t frame, const char *format, Logger::EncodeFunction encode, const void *arguments)
+{
+  if (queue.Push(type, frame, format, encode, arguments) && isSleeping.load(std::memory_order_relaxed) &&
+      queue.GetEnqueuePosition() - queue.GetDequeuePosition() >= LOG_WRITER_WAKE_THRESHOLD)
+  {
+    {
+      std::lock_guard<std::mutex> wakeLock(wakeMutex);
+      isSleeping = false;
+    }
+    wakeCondition.notify_one();
+    // Let the writer run now, a burst on a busy core would otherwise fill the queue first
+    std::this_thread::yield();
+  }
+}
+
+void LogWriter::Flush()
+{
+  const size_t target = queue.GetEnqueuePosition();
+  while (numWritten.load(std::memory_order_acquire) < target)
+  {
+    std::this_thread::yield();
+  }
+}
+
+void LogWriter::SetTimestampMode(LogTimestampMode mode)
+{
+  std::lock_guard<std::mutex> lock(outputMutex);
+  timestampMode = mode;
+}
+
+void LogWriter::SetConsoleOutput(bool isEnabled)
+{
+  std::lock_guard<std::mutex> lock(outputMutex);
+  isConsoleEnabled = isEnabled;
+}
+
+void LogWriter::SetFileOutput(const std::string &path)
+{
+  std::lock_guard<std::mutex> lock(outputMutex);
+  if (file)
+  {
+    fclose(file);
+    file = nullptr;
+  }
+  if (!path.empty())
+  {
+    file = fopen(path.c_str(), "a");
+  }
+}
+
+void LogWriter::SetBinaryFileOutput(const std::string &path)
+{
+  std::lock_guard<std::mutex> lock(outputMutex);
+  if (binaryFile)
+  {
+    fclose(binaryFile);
+    binaryFile = nullptr;
+  }
+  binaryFormatIds.clear();
+  if (!path.empty())
+  {
+    binaryFile = fopen(path.c_str(), "wb");
+    if (binaryFile)
+    {
+      fwrite(LOG_BINARY_MAGIC, 1, sizeof(LOG_BINARY_MAGIC), binaryFile);
+    }
+  }
+}
+
+// Used once the writer thread is gone
+static void WriteSynchronously(LogType type, const char *format, Logger::EncodeFunction encode, const void *arguments)
+{
+  char buffer[LOG_RECORD_ARGUMENTS_SIZE];
+  const size_t length = encode(buffer, sizeof(buffer), arguments);
+  std::string expanded;
+  const std::string message = ExpandLogArguments(buffer, length, expanded) ? FormatLogArguments(format, expanded.data(), expanded.size())
+                                                                           : FormatLogArguments(format, buffer, length);
+  const char *prefix = (type == LOG_ERROR) ? "\x1B[91mERR: [" : "\x1B[32mLOG: [";
+  std::cout << prefix << DateTimeToString(std::chrono::system_clock::now()) << "]: " << message << "\033[0m" << std::endl;
+}
+
+void Logger::Write(LogType type, const char *format, EncodeFunction encode, const void *arguments)
+{
+  if (isWriterDestroyed)
+  {
+    WriteSynchronously(type, format, encode, arguments);
+    return;
+  }
+  writer.Push(type, frameNumber.load(std::memory_order_relaxed), format, encode, arguments);
+}
+
+void Logger::Log(const std::string &message)
+{
+  Logf("%s", message);
 }
 
 void Logger::Err(const std::string &message)
 {
-  LogEntry logEntry;
-  logEntry.type = LOG_ERROR;
+  Errf("%s", message);
+}
 
-  logEntry.message = "ERR: [" + CurrentDateTimeToString() + "]: " + message;
-  std::cout << "\x1B[91m" << logEntry.message << "\033[0m" << std::endl;
+void Logger::Flush()
+{
+  if (!isWriterDestroyed)
+  {
+    writer.Flush();
+  }
+}
 
-  messages.push_back(logEntry);
-}
\ No newline at end of file
+void Logger::SetConsoleOutput(bool isEnabled)
+{
+  writer.SetConsoleOutput(isEnabled);
+}
+
+void Logger::SetFileOutput(const std::string &path)
+{
+  writer.SetFileOutput(path);
+}
+
+void Logger::SetBinaryFileOutput(const std::string &path)
+{
+  writer.SetBinaryFileOutput(path);
+}
+
+size_t Logger::GetNumDropped()
+{
+  return writer.GetNumDropped();
+}
+
+void Logger::SetTimestampMode(LogTimestampMode mode)
+{
+  writer.SetTimestampMode(mode);
+}
+
+void Logger::SetFrameNumber(uint64_t frame)
+{
+  frameNumber.store(frame, std::memory_order_relaxed);
+}
+
+LogHistory &Logger::GetHistory()
+{
+  return history;
+}
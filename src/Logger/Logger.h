@@ -2,6 +2,41 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <tuple>
+#include "LogFormat.h"
+
+// Log levels, the logs below LOG_MIN_LEVEL are compiled out.
+// Release builds (NDEBUG) drop the trace logs entirely.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_ERROR 2
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Trace categories, off by default since they log on hot paths.
+// Enable one at compile time, e.g. -DLOG_TRACE_ECS=1
+#ifndef LOG_TRACE_ECS
+#define LOG_TRACE_ECS 0
+#endif
+
+// Logs a trace message of the given category with a printf-like format,
+// e.g. LOG_TRACE(ECS, "Entity created with id: %d", entityId).
+// When the category or the trace level is disabled the arguments are never
+// evaluated, so the call costs nothing at runtime.
+#define LOG_TRACE(category, ...)                                            \
+  do                                                                        \
+  {                                                                         \
+    if constexpr (LOG_MIN_LEVEL <= LOG_LEVEL_TRACE && LOG_TRACE_##category) \
+    {                                                                       \
+      Logger::Logf(__VA_ARGS__);                                            \
+    }                                                                       \
+  } while (0)
 
 enum LogType
 {
@@ -10,16 +45,89 @@ enum LogType
   LOG_ERROR
 };
 
-struct LogEntry
+// What the messages are prefixed with
+enum LogTimestampMode
 {
-  LogType type;
-  std::string message;
+  LOG_TIMESTAMP_DATE_TIME, // e.g. [16-Oct-2026 17:06:32.125]
+  LOG_TIMESTAMP_FRAME      // e.g. [frame 1234], as given to Logger::SetFrameNumber
 };
 
+class LogHistory;
+
+// Log and Err only copy the message into a lock-free queue, a background
+// thread formats the records and writes them in batches to the console
+// and the optional log files. If the queue is full the message is dropped,
+// and the writer reports how many were lost.
+// Logf and Errf go further and defer the formatting itself: they capture the
+// format string (which must be a string literal) and the raw bytes of their
+// arguments, e.g. Logger::Logf("Entity %d spawned at %.1f", entityId, x)
+// A queued record has room for 216 bytes of arguments: 9 per number, 3 plus the
+// characters per string. A string that doesn't fit in what is left (e.g. a
+// message of Log longer than 213 characters) is copied on the heap instead, so
+// messages are never cut, at the cost of an allocation on the calling thread.
+// Past about 16 numbers the extra arguments are left out, and their conversions
+// appear as is in the message. The history keeps the first 1024 characters of
+// each message, see LogHistory.
 class Logger
 {
+private:
+  template <typename... TArgs>
+  static size_t EncodeArguments(char *buffer, size_t capacity, const void *arguments);
+
 public:
-  static std::vector<LogEntry> messages;
+  // Encodes the arguments of a log call in a record
+  typedef size_t (*EncodeFunction)(char *buffer, size_t capacity, const void *arguments);
+
   static void Log(const std::string &message);
   static void Err(const std::string &message);
-};
\ No newline at end of file
+
+  template <typename... TArgs>
+  static void Logf(const char *format, const TArgs &...args);
+  template <typename... TArgs>
+  static void Errf(const char *format, const TArgs &...args);
+
+  // Queues a log call, used by all of the above
+  static void Write(LogType type, const char *format, EncodeFunction encode, const void *arguments);
+
+  // Blocks until every message logged so far has been written
+  static void Flush();
+
+  static void SetConsoleOutput(bool isEnabled);
+  // Also write the messages to a file, an empty path closes the current one
+  static void SetFileOutput(const std::string &path);
+  // Also write the records, unformatted, to a compact binary file read by the log decoder tool
+  static void SetBinaryFileOutput(const std::string &path);
+
+  static size_t GetNumDropped();
+
+  static void SetTimestampMode(LogTimestampMode mode);
+  // Called by the game loop at the start of every frame, each message records the current frame
+  static void SetFrameNumber(uint64_t frame);
+
+  // Last messages logged, kept in memory for the debug console
+  static LogHistory &GetHistory();
+};
+
+template <typename... TArgs>
+size_t Logger::EncodeArguments(char *buffer, size_t capacity, const void *arguments)
+{
+  LogArgumentEncoder encoder(buffer, capacity);
+  std::apply([&encoder](const TArgs &...args)
+             { (encoder.Encode(args), ...); },
+             *static_cast<const std::tuple<const TArgs &...> *>(arguments));
+  return encoder.GetLength();
+}
+
+template <typename... TArgs>
+void Logger::Logf(const char *format, const TArgs &...args)
+{
+  const std::tuple<const TArgs &...> arguments(args...);
+  Write(LOG_INFO, format, &EncodeArguments<TArgs...>, &arguments);
+}
+
+template <typename... TArgs>
+void Logger::Errf(const char *format, const TArgs &...args)
+{
+  const std::tuple<const TArgs &...> arguments(args...);
+  Write(LOG_ERROR, format, &EncodeArguments<TArgs...>, &arguments);
+}
\ No newline at end of file
@@ -1,13 +1,78 @@
 #include <iostream>
+#include <cstdlib>
+#include <string>
 #include "Game/Game.h"
+#include "Logger/Logger.h"
+#include "Profiler/Profiler.h"
 
+// Usage: gameengine [--headless] [--tick-rate <ticks per second>] [--ticks <count>] [--profile <trace.json>]
+//   --headless   run the simulation only, without window, renderer nor audio
+//   --tick-rate  headless steps per second, as fast as possible when omitted
+//   --ticks      stop after this many simulation steps
+//   --profile    record the profiler zones and write them to a Chrome trace file on exit
 int main(int argc, char *argv[])
 {
+    bool isHeadless = false;
+    int tickRate = 0;
+    unsigned long long tickLimit = 0;
+    std::string profilePath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--headless")
+        {
+            isHeadless = true;
+        }
+        else if (argument == "--tick-rate" && i + 1 < argc)
+        {
+            tickRate = std::atoi(argv[++i]);
+            if (tickRate <= 0)
+            {
+                Logger::Errf("--tick-rate expects a positive number of ticks per second, got %s", argv[i]);
+                return 1;
+            }
+        }
+        else if (argument == "--ticks" && i + 1 < argc)
+        {
+            tickLimit = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--profile" && i + 1 < argc)
+        {
+            profilePath = argv[++i];
+        }
+        else
+        {
+            Logger::Errf("Unknown argument: %s", argument);
+            return 1;
+        }
+    }
+
     Game game;
+    game.SetHeadless(isHeadless, tickRate);
+    game.SetTickLimit(tickLimit);
+
+    if (!profilePath.empty())
+    {
+        Profiler::StartCapture();
+    }
 
     game.Initialize();
     game.Run();
     game.Destroy();
 
+    if (!profilePath.empty())
+    {
+        Profiler::StopCapture();
+        if (Profiler::ExportChromeTrace(profilePath))
+        {
+            Logger::Logf("Profile written to %s", profilePath);
+        }
+        else
+        {
+            Logger::Errf("Error writing the profile to %s", profilePath);
+        }
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,212 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <vector>
+
+struct ProfileEvent
+{
+  const char *name;
+  int64_t start;
+  int64_t end;
+};
+
+// Time spent in a zone over the current frame
+struct ProfileZoneTotal
+{
+  const char *name;
+  int64_t firstStart;
+  int64_t ticks;
+  int count;
+};
+
+// Zones recorded by one thread. The buffer is shared with the profiler so that
+// the zones of a thread can still be exported once it has exited.
+struct ProfileThreadBuffer
+{
+  // Only contended while exporting or clearing
+  std::mutex mutex;
+  // Allocated on the first zone captured
+  std::vector<ProfileEvent> events;
+  // Zones recorded since the last Clear, the buffer holds the last PROFILER_EVENTS_PER_THREAD
+  size_t numEvents = 0;
+  int threadId = 0;
+
+  // Per-frame totals, only used by the owning thread
+  std::vector<ProfileZoneTotal> currentFrame;
+  std::vector<ProfileZoneTotal> lastFrame;
+};
+
+std::atomic<bool> Profiler::isCapturing{false};
+std::atomic<bool> Profiler::isSummarizing{false};
+
+static std::mutex buffersMutex;
+static std::vector<std::shared_ptr<ProfileThreadBuffer>> buffers;
+
+static ProfileThreadBuffer &GetThreadBuffer()
+{
+  thread_local std::shared_ptr<ProfileThreadBuffer> buffer;
+  if (!buffer)
+  {
+    buffer = std::make_shared<ProfileThreadBuffer>();
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->threadId = static_cast<int>(buffers.size());
+    buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void Profiler::StartCapture()
+{
+  Clock::Calibrate();
+  isCapturing.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::StopCapture()
+{
+  isCapturing.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::SetSummaryEnabled(bool isEnabled)
+{
+  Clock::Calibrate();
+  isSummarizing.store(isEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::Record(const char *name, int64_t start, int64_t end)
+{
+  ProfileThreadBuffer &buffer = GetThreadBuffer();
+
+  if (isSummarizing.load(std::memory_order_relaxed))
+  {
+    // A frame only has a handful of distinct zones, a linear search is the fastest
+    auto total = std::find_if(buffer.currentFrame.begin(), buffer.currentFrame.end(), [name](const ProfileZoneTotal &zone)
+                              { return zone.name == name; });
+    if (total == buffer.currentFrame.end())
+    {
+      buffer.currentFrame.push_back(ProfileZoneTotal{name, start, 0, 0});
+      total = buffer.currentFrame.end() - 1;
+    }
+    total->firstStart = std::min(total->firstStart, start);
+    total->ticks += end - start;
+    total->count++;
+  }
+
+  if (IsCapturing())
+  {
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.empty())
+    {
+      buffer.events.resize(PROFILER_EVENTS_PER_THREAD);
+    }
+    buffer.events[buffer.numEvents % PROFILER_EVENTS_PER_THREAD] = ProfileEvent{name, start, end};
+    buffer.numEvents++;
+  }
+}
+
+void Profiler::EndFrame()
+{
+  ProfileThreadBuffer &buffer = GetThreadBuffer();
+  std::swap(buffer.currentFrame, buffer.lastFrame);
+  buffer.currentFrame.clear();
+}
+
+std::vector<ProfileZoneSummary> Profiler::GetFrameSummary()
+{
+  ProfileThreadBuffer &buffer = GetThreadBuffer();
+  std::vector<ProfileZoneTotal> totals = buffer.lastFrame;
+  std::sort(totals.begin(), totals.end(), [](const ProfileZoneTotal &a, const ProfileZoneTotal &b)
+            { return a.firstStart < b.firstStart; });
+
+  const double millisecondsPerTick = Clock::GetNanosecondsPerTick() / 1000000.0;
+  std::vector<ProfileZoneSummary> summary;
+  summary.reserve(totals.size());
+  for (const ProfileZoneTotal &total : totals)
+  {
+    summary.push_back(ProfileZoneSummary{total.name, total.ticks * millisecondsPerTick, total.count});
+  }
+  return summary;
+}
+
+void Profiler::Clear()
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for (auto &buffer : buffers)
+  {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->numEvents = 0;
+  }
+}
+
+// Writes a zone name as a JSON string
+static void WriteJsonString(FILE *file, const char *text)
+{
+  fputc('"', file);
+  for (; *text; text++)
+  {
+    if (*text == '"' || *text == '\\')
+    {
+      fputc('\\', file);
+      fputc(*text, file);
+    }
+    else if (static_cast<unsigned char>(*text) < 0x20)
+    {
+      fprintf(file, "\\u%04x", *text);
+    }
+    else
+    {
+      fputc(*text, file);
+    }
+  }
+  fputc('"', file);
+}
+
+bool Profiler::ExportChromeTrace(const std::string &path)
+{
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  const double microsecondsPerTick = Clock::GetNanosecondsPerTick() / 1000.0;
+
+  // Times are written in microseconds since the first zone kept
+  int64_t origin = INT64_MAX;
+  for (auto &buffer : buffers)
+  {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    const size_t numKept = std::min(buffer->numEvents, PROFILER_EVENTS_PER_THREAD);
+    for (size_t i = 0; i < numKept; i++)
+    {
+      origin = std::min(origin, buffer->events[i].start);
+    }
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool isFirst = true;
+  for (auto &buffer : buffers)
+  {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    const size_t numKept = std::min(buffer->numEvents, PROFILER_EVENTS_PER_THREAD);
+    const size_t first = buffer->numEvents - numKept;
+    for (size_t i = first; i < buffer->numEvents; i++)
+    {
+      const ProfileEvent &event = buffer->events[i % PROFILER_EVENTS_PER_THREAD];
+      fprintf(file, isFirst ? "\n{\"name\":" : ",\n{\"name\":");
+      WriteJsonString(file, event.name);
+      fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+              (event.start - origin) * microsecondsPerTick, (event.end - event.start) * microsecondsPerTick, buffer->threadId);
+      isFirst = false;
+    }
+  }
+  fprintf(file, "\n]}\n");
+
+  const bool isWritten = !ferror(file);
+  fclose(file);
+  return isWritten;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "../Clock/Clock.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zones can be compiled out entirely with -DPROFILER_ENABLED=0
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+// Times the rest of the enclosing scope, e.g. PROFILE_ZONE("MovementSystem::Update").
+// The name must be a string literal, only its pointer is recorded.
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) \
+  do                       \
+  {                        \
+  } while (0)
+#endif
+
+// Most zones kept per thread, the oldest ones are overwritten first
+const size_t PROFILER_EVENTS_PER_THREAD = 1 << 18;
+
+// Total time spent in a zone over a frame
+struct ProfileZoneSummary
+{
+  const char *name;
+  double milliseconds;
+  int count;
+};
+
+// Records the time spent in nested scoped zones while capturing.
+// Every thread writes its zones to its own circular buffer, so the only cost of
+// a zone is reading the clock twice and storing one event, and the buffers can
+// be exported to the Chrome trace event format, viewable in chrome://tracing or Perfetto.
+class Profiler
+{
+private:
+  static std::atomic<bool> isCapturing;
+  static std::atomic<bool> isSummarizing;
+
+public:
+  static void StartCapture();
+  static void StopCapture();
+  static bool IsCapturing() { return isCapturing.load(std::memory_order_relaxed); }
+
+  // While enabled, the total time of each zone is also kept per frame, e.g. for an overlay
+  static void SetSummaryEnabled(bool isEnabled);
+  // Ends the frame of the calling thread, the totals of its zones become its summary
+  static void EndFrame();
+  // Zones of the last frame ended by the calling thread, by order of their first start
+  static std::vector<ProfileZoneSummary> GetFrameSummary();
+
+  // Whether the zones are timed at all
+  static bool IsActive() { return IsCapturing() || isSummarizing.load(std::memory_order_relaxed); }
+
+  // Called by ProfileZone when it ends
+  static void Record(const char *name, int64_t start, int64_t end);
+
+  // Forgets every zone recorded so far
+  static void Clear();
+
+  // Writes the zones recorded by all the threads to a JSON file, returns false if it can't be written
+  static bool ExportChromeTrace(const std::string &path);
+};
+
+class ProfileZone
+{
+private:
+  const char *name;
+  int64_t start;
+
+public:
+  ProfileZone(const char *name) : name(Profiler::IsActive() ? name : nullptr), start(this->name ? Clock::Now() : 0) {}
+  ~ProfileZone()
+  {
+    if (name)
+    {
+      Profiler::Record(name, start, Clock::Now());
+    }
+  }
+
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+};
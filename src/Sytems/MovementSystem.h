@@ -1,5 +1,6 @@
 #pragma once
 #include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/RigidBodyComponent.h"
 
@@ -14,13 +15,13 @@ public:
 
   void Update(double deltaTime)
   {
-    // Loop all entities that the system is interested in
-    for (auto entity : GetSystemEntities())
+    PROFILE_ZONE("MovementSystem::Update");
+
+    // Loop all entities that have the components the system is interested in
+    for (auto [entity, transform, rigidBody] : View<TransformComponent, RigidBodyComponent>())
     {
       // Update entity position based on its velocity
-      auto &transform = entity.GetComponent<TransformComponent>();
-      const auto rigidBody = entity.GetComponent<RigidBodyComponent>();
-
+      transform.previousPosition = transform.position;
       transform.position.x += rigidBody.velocity.x * deltaTime;
       transform.position.y += rigidBody.velocity.y * deltaTime;
     }
@@ -1,11 +1,86 @@
 #pragma once
 #include "../ECS/ECS.h"
+#include "../Profiler/Profiler.h"
+#include "../AssetStore/AssetStore.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/SpriteComponent.h"
 #include <SDL.h>
+#include <vector>
 
 class RenderSystem : public System
 {
+private:
+  struct SpriteDraw
+  {
+    int textureId;
+    SDL_Rect srcRect;
+    SDL_FRect dstRect;
+  };
+
+  // Everything below is kept between frames so the batches don't allocate once they have grown
+  std::vector<SpriteDraw> sprites;
+  // Sprites grouped by texture, and where the group of each texture id starts
+  std::vector<SpriteDraw> sortedSprites;
+  std::vector<int> textureOffsets;
+  std::vector<SDL_Rect> rects;
+  std::vector<SDL_Vertex> vertices;
+  std::vector<int> indices;
+  int numDrawCalls = 0;
+
+  void DrawRects(SDL_Renderer *renderer, const SpriteDraw *begin, const SpriteDraw *end)
+  {
+    rects.clear();
+    for (const SpriteDraw *sprite = begin; sprite != end; sprite++)
+    {
+      rects.push_back({static_cast<int>(sprite->dstRect.x),
+                       static_cast<int>(sprite->dstRect.y),
+                       static_cast<int>(sprite->dstRect.w),
+                       static_cast<int>(sprite->dstRect.h)});
+    }
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderFillRects(renderer, rects.data(), static_cast<int>(rects.size()));
+    numDrawCalls++;
+  }
+
+  // Two triangles per sprite, all sent in a single call
+  void DrawTextured(SDL_Renderer *renderer, const TextureAsset &texture, const SpriteDraw *begin, const SpriteDraw *end)
+  {
+    const float uScale = 1.0f / texture.width;
+    const float vScale = 1.0f / texture.height;
+    const SDL_Color color = {255, 255, 255, 255};
+
+    const int numSprites = static_cast<int>(end - begin);
+    vertices.resize(numSprites * 4);
+    indices.resize(numSprites * 6);
+    for (int i = 0; i < numSprites; i++)
+    {
+      const SDL_FRect &dst = begin[i].dstRect;
+      const SDL_Rect &src = begin[i].srcRect;
+      const float u0 = src.x * uScale;
+      const float v0 = src.y * vScale;
+      const float u1 = (src.x + src.w) * uScale;
+      const float v1 = (src.y + src.h) * vScale;
+
+      SDL_Vertex *vertex = &vertices[i * 4];
+      vertex[0] = {{dst.x, dst.y}, color, {u0, v0}};
+      vertex[1] = {{dst.x + dst.w, dst.y}, color, {u1, v0}};
+      vertex[2] = {{dst.x + dst.w, dst.y + dst.h}, color, {u1, v1}};
+      vertex[3] = {{dst.x, dst.y + dst.h}, color, {u0, v1}};
+
+      int *index = &indices[i * 6];
+      const int first = i * 4;
+      index[0] = first;
+      index[1] = first + 1;
+      index[2] = first + 2;
+      index[3] = first;
+      index[4] = first + 2;
+      index[5] = first + 3;
+    }
+    SDL_RenderGeometry(renderer, texture.texture, vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+    numDrawCalls++;
+  }
+
 public:
   RenderSystem()
   {
@@ -13,22 +88,61 @@ public:
     RequireComponent<SpriteComponent>();
   }
 
-  void Update(SDL_Renderer *renderer)
+  // Number of SDL draw calls issued by the last update
+  int GetNumDrawCalls() const { return numDrawCalls; }
+
+  // alpha tells how far the frame is between the previous simulation step (0) and the last one (1)
+  void Update(SDL_Renderer *renderer, const AssetStore &assetStore, const SDL_Rect &camera, double alpha)
   {
-    // Loop all entities that the system is interested in
-    for (auto entity : GetSystemEntities())
+    PROFILE_ZONE("RenderSystem::Update");
+    const int numTextureIds = assetStore.GetNumTextureIds();
+
+    // Loop all entities that have the components the system is interested in
+    sprites.clear();
+    for (auto [entity, transform, sprite] : View<TransformComponent, SpriteComponent>())
     {
-      const auto transform = entity.GetComponent<TransformComponent>();
-      const auto sprite = entity.GetComponent<SpriteComponent>();
+      const glm::vec2 position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(alpha)) -
+                                 glm::vec2(camera.x, camera.y);
+      const int textureId = sprite.textureId > 0 && sprite.textureId < numTextureIds ? sprite.textureId : NO_TEXTURE;
+      sprites.push_back({textureId,
+                         {sprite.srcX, sprite.srcY, sprite.width, sprite.height},
+                         {position.x, position.y, sprite.width * transform.scale.x, sprite.height * transform.scale.y}});
+    }
 
-      SDL_Rect objRect = {
-          static_cast<int>(transform.position.x),
-          static_cast<int>(transform.position.y),
-          sprite.width,
-          sprite.height};
+    // Group the sprites by texture with a counting sort, texture ids being small integers
+    textureOffsets.assign(numTextureIds + 1, 0);
+    for (const SpriteDraw &sprite : sprites)
+    {
+      textureOffsets[sprite.textureId + 1]++;
+    }
+    for (int textureId = 0; textureId < numTextureIds; textureId++)
+    {
+      textureOffsets[textureId + 1] += textureOffsets[textureId];
+    }
+    sortedSprites.resize(sprites.size());
+    for (const SpriteDraw &sprite : sprites)
+    {
+      sortedSprites[textureOffsets[sprite.textureId]++] = sprite;
+    }
 
-      SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-      SDL_RenderFillRect(renderer, &objRect);
+    // Each offset now points to the end of its group, which is also where the next one starts
+    numDrawCalls = 0;
+    const SpriteDraw *begin = sortedSprites.data();
+    for (int textureId = 0; textureId < numTextureIds; textureId++)
+    {
+      const SpriteDraw *end = sortedSprites.data() + textureOffsets[textureId];
+      if (begin != end)
+      {
+        if (textureId == NO_TEXTURE)
+        {
+          DrawRects(renderer, begin, end);
+        }
+        else if (assetStore.GetTexture(textureId))
+        {
+          DrawTextured(renderer, assetStore.GetTextureAsset(textureId), begin, end);
+        }
+      }
+      begin = end;
     }
   }
-};
\ No newline at end of file
+};
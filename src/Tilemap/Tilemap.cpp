@@ -0,0 +1,256 @@
+#include "Tilemap.h"
+#include "../AssetStore/AssetStore.h"
+#include "../Logger/Logger.h"
+#include "../Profiler/Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+Tilemap::~Tilemap()
+{
+  Destroy();
+}
+
+bool Tilemap::Load(const std::string &mapPath, const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale)
+{
+  std::ifstream file(mapPath);
+  if (!file)
+  {
+    Logger::Errf("Error opening the tilemap %s", mapPath);
+    return false;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+
+  Unload();
+  std::string error;
+  if (!ParseTilemapCsv(text.str(), tileStorage, width, height, error))
+  {
+    Logger::Errf("Error parsing the tilemap %s: %s", mapPath, error);
+    Unload();
+    return false;
+  }
+  tiles = tileStorage.data();
+
+  if (!InitializeChunks(assetStore, tilesetTextureId, tileSize, scale, error))
+  {
+    Logger::Errf("Error loading the tilemap %s: %s", mapPath, error);
+    Unload();
+    return false;
+  }
+  Logger::Logf("Tilemap %s loaded: %dx%d tiles, %d chunks", mapPath, width, height, numChunksX * numChunksY);
+  return true;
+}
+
+bool Tilemap::LoadBinary(const std::string &mapPath, const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale)
+{
+  Unload();
+  std::string error;
+  if (!binaryFile.Open(mapPath, error))
+  {
+    if (binaryFile.IsMissing())
+    {
+      Logger::Logf("No binary tilemap %s", mapPath);
+    }
+    else
+    {
+      Logger::Errf("Error loading the tilemap %s: %s", mapPath, error);
+    }
+    return false;
+  }
+  if (binaryFile.GetNumLayers() == 0)
+  {
+    Logger::Errf("The tilemap %s has no layer", mapPath);
+    Unload();
+    return false;
+  }
+
+  width = binaryFile.GetWidth();
+  height = binaryFile.GetHeight();
+  if (binaryFile.IsLayerCompressed(0))
+  {
+    if (!binaryFile.DecompressLayer(0, tileStorage))
+    {
+      Logger::Errf("Error decompressing the tilemap %s", mapPath);
+      Unload();
+      return false;
+    }
+    binaryFile.Close();
+    tiles = tileStorage.data();
+  }
+  else
+  {
+    // The tiles stay in the file, the memory only holds the pages read so far
+    tiles = binaryFile.GetLayerTiles(0);
+  }
+
+  if (!InitializeChunks(assetStore, tilesetTextureId, tileSize, scale, error))
+  {
+    Logger::Errf("Error loading the tilemap %s: %s", mapPath, error);
+    Unload();
+    return false;
+  }
+  Logger::Logf("Tilemap %s loaded: %dx%d tiles, %d chunks", mapPath, width, height, numChunksX * numChunksY);
+  return true;
+}
+
+void Tilemap::Unload()
+{
+  Destroy();
+  chunks.clear();
+  numChunksX = 0;
+  numChunksY = 0;
+  binaryFile.Close();
+  tileStorage.clear();
+  tileStorage.shrink_to_fit();
+  tiles = nullptr;
+  width = 0;
+  height = 0;
+}
+
+bool Tilemap::InitializeChunks(const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale, std::string &error)
+{
+  if (tileSize <= 0)
+  {
+    error = "invalid tile size " + std::to_string(tileSize);
+    return false;
+  }
+  // The tiles are numbered by rows of the tileset, it needs at least one column
+  const TextureAsset &tileset = assetStore.GetTextureAsset(tilesetTextureId);
+  if (tileset.texture && tileset.width < tileSize)
+  {
+    error = "the tileset " + tileset.path + " is " + std::to_string(tileset.width) +
+            " pixels wide, less than a tile of " + std::to_string(tileSize);
+    return false;
+  }
+
+  this->tilesetTextureId = tilesetTextureId;
+  this->tileSize = tileSize;
+  this->scale = scale;
+  numChunksX = (width + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  numChunksY = (height + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+  chunks.assign(numChunksX * numChunksY, Chunk());
+  return true;
+}
+
+void Tilemap::Destroy()
+{
+  for (Chunk &chunk : chunks)
+  {
+    if (chunk.texture)
+    {
+      SDL_DestroyTexture(chunk.texture);
+      chunk.texture = nullptr;
+    }
+    chunk.isDirty = true;
+  }
+}
+
+void Tilemap::SetTile(int x, int y, int tile)
+{
+  if (!IsInside(x, y))
+  {
+    Logger::Errf("SetTile called at %d,%d, outside of the %dx%d tilemap", x, y, width, height);
+    return;
+  }
+  if (tile < 0 || tile > UINT16_MAX)
+  {
+    Logger::Errf("SetTile called with the tile index %d, out of the 0-65535 range", tile);
+    return;
+  }
+  tiles[y * width + x] = static_cast<uint16_t>(tile);
+  chunks[(y / TILEMAP_CHUNK_SIZE) * numChunksX + x / TILEMAP_CHUNK_SIZE].isDirty = true;
+}
+
+void Tilemap::Invalidate()
+{
+  for (Chunk &chunk : chunks)
+  {
+    chunk.isDirty = true;
+  }
+}
+
+void Tilemap::BakeChunk(SDL_Renderer *renderer, const AssetStore &assetStore, int chunkX, int chunkY)
+{
+  PROFILE_ZONE("Tilemap::BakeChunk");
+  Chunk &chunk = chunks[chunkY * numChunksX + chunkX];
+  const TextureAsset &tileset = assetStore.GetTextureAsset(tilesetTextureId);
+  const int tilesetColumns = tileset.width / tileSize;
+
+  // The chunks on the right and bottom edges may have less tiles
+  const int firstX = chunkX * TILEMAP_CHUNK_SIZE;
+  const int firstY = chunkY * TILEMAP_CHUNK_SIZE;
+  const int numTilesX = std::min(TILEMAP_CHUNK_SIZE, width - firstX);
+  const int numTilesY = std::min(TILEMAP_CHUNK_SIZE, height - firstY);
+
+  if (chunk.texture == nullptr)
+  {
+    chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                      numTilesX * tileSize, numTilesY * tileSize);
+    if (chunk.texture == nullptr)
+    {
+      Logger::Errf("Error creating the texture of a tilemap chunk: %s", SDL_GetError());
+      return;
+    }
+    SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+  }
+
+  SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+  SDL_SetRenderTarget(renderer, chunk.texture);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+  for (int y = 0; y < numTilesY; y++)
+  {
+    for (int x = 0; x < numTilesX; x++)
+    {
+      const int tile = tiles[(firstY + y) * width + firstX + x];
+      SDL_Rect srcRect = {(tile % tilesetColumns) * tileSize, (tile / tilesetColumns) * tileSize, tileSize, tileSize};
+      SDL_Rect dstRect = {x * tileSize, y * tileSize, tileSize, tileSize};
+      SDL_RenderCopy(renderer, tileset.texture, &srcRect, &dstRect);
+    }
+  }
+  SDL_SetRenderTarget(renderer, previousTarget);
+  chunk.isDirty = false;
+}
+
+void Tilemap::Render(SDL_Renderer *renderer, const AssetStore &assetStore, const SDL_Rect &camera)
+{
+  PROFILE_ZONE("Tilemap::Render");
+  numDrawCalls = 0;
+  if (chunks.empty() || assetStore.GetTexture(tilesetTextureId) == nullptr)
+  {
+    return;
+  }
+
+  // Range of chunks intersecting the camera
+  const float chunkPixels = TILEMAP_CHUNK_SIZE * tileSize * scale;
+  const int firstChunkX = std::max(0, static_cast<int>(camera.x / chunkPixels));
+  const int firstChunkY = std::max(0, static_cast<int>(camera.y / chunkPixels));
+  const int lastChunkX = std::min(numChunksX - 1, static_cast<int>((camera.x + camera.w) / chunkPixels));
+  const int lastChunkY = std::min(numChunksY - 1, static_cast<int>((camera.y + camera.h) / chunkPixels));
+
+  for (int chunkY = firstChunkY; chunkY <= lastChunkY; chunkY++)
+  {
+    for (int chunkX = firstChunkX; chunkX <= lastChunkX; chunkX++)
+    {
+      Chunk &chunk = chunks[chunkY * numChunksX + chunkX];
+      if (chunk.isDirty)
+      {
+        BakeChunk(renderer, assetStore, chunkX, chunkY);
+      }
+      if (chunk.texture == nullptr)
+      {
+        continue;
+      }
+
+      const int numTilesX = std::min(TILEMAP_CHUNK_SIZE, width - chunkX * TILEMAP_CHUNK_SIZE);
+      const int numTilesY = std::min(TILEMAP_CHUNK_SIZE, height - chunkY * TILEMAP_CHUNK_SIZE);
+      SDL_FRect dstRect = {chunkX * chunkPixels - camera.x,
+                           chunkY * chunkPixels - camera.y,
+                           numTilesX * tileSize * scale,
+                           numTilesY * tileSize * scale};
+      SDL_RenderCopyF(renderer, chunk.texture, NULL, &dstRect);
+      numDrawCalls++;
+    }
+  }
+}
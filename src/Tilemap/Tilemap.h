@@ -0,0 +1,81 @@
+#pragma once
+#include "TilemapFormat.h"
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+class AssetStore;
+
+// Side of a chunk, in tiles
+const int TILEMAP_CHUNK_SIZE = 16;
+
+// Returned by GetTile outside of the map
+const int NO_TILE = -1;
+
+// Static background made of tiles taken from a tileset texture.
+// The tiles are baked once into a render target texture per chunk of
+// TILEMAP_CHUNK_SIZE x TILEMAP_CHUNK_SIZE tiles, and a frame only draws the
+// chunks the camera sees: a few draw calls whatever the size of the map.
+class Tilemap
+{
+private:
+  struct Chunk
+  {
+    SDL_Texture *texture = nullptr;
+    // The texture doesn't match the tiles anymore, or doesn't exist yet
+    bool isDirty = true;
+  };
+
+  // Tile indices, row after row. A tile index is row * tileset columns + column in the tileset.
+  // Points either to tileStorage or right into the mapped binary file.
+  uint16_t *tiles = nullptr;
+  std::vector<uint16_t> tileStorage;
+  BinaryTilemapFile binaryFile;
+  int width = 0;
+  int height = 0;
+
+  int tilesetTextureId = 0;
+  int tileSize = 0;
+  float scale = 1.0f;
+
+  std::vector<Chunk> chunks;
+  int numChunksX = 0;
+  int numChunksY = 0;
+  int numDrawCalls = 0;
+
+  // Forgets the tiles and the chunks
+  void Unload();
+  // Checks the tile size against the tileset, then splits the tiles loaded into chunks
+  bool InitializeChunks(const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale, std::string &error);
+  void BakeChunk(SDL_Renderer *renderer, const AssetStore &assetStore, int chunkX, int chunkY);
+
+public:
+  ~Tilemap();
+
+  // Parses a map of comma separated tile indices, one line per row of tiles.
+  // tileSize is the side of a tile in the tileset, scale how bigger it is drawn.
+  // Fails if tileSize isn't positive or the tileset is narrower than a tile,
+  // the tileset not being loaded (e.g. without a renderer) is fine.
+  bool Load(const std::string &mapPath, const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale);
+  // Same with the first layer of a binary tilemap written by tools/TilemapConverter, see TilemapFormat.h.
+  // A missing file is only logged as information, as the caller usually falls back to the CSV map.
+  bool LoadBinary(const std::string &mapPath, const AssetStore &assetStore, int tilesetTextureId, int tileSize, float scale);
+  // Frees the chunk textures
+  void Destroy();
+
+  int GetWidth() const { return width; }
+  int GetHeight() const { return height; }
+  bool IsInside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+  // NO_TILE outside of the map
+  int GetTile(int x, int y) const { return IsInside(x, y) ? tiles[y * width + x] : NO_TILE; }
+  // Changes a tile, its chunk is baked again before it is drawn next.
+  // Logs an error and changes nothing outside of the map, or for a tile index that doesn't fit in 16 bits.
+  void SetTile(int x, int y, int tile);
+  // Bakes every chunk again, e.g. after SDL_RENDER_TARGETS_RESET lost the content of the textures
+  void Invalidate();
+
+  // Draws the chunks that intersect the camera, baking them first if needed
+  void Render(SDL_Renderer *renderer, const AssetStore &assetStore, const SDL_Rect &camera);
+  // Number of SDL draw calls issued by the last render, baking excluded
+  int GetNumDrawCalls() const { return numDrawCalls; }
+};
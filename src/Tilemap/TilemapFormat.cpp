@@ -0,0 +1,377 @@
+#include "TilemapFormat.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool ParseTilemapCsv(const std::string &text, std::vector<uint16_t> &tiles, int &width, int &height, std::string &error)
+{
+  tiles.clear();
+  width = 0;
+  height = 0;
+
+  int rowWidth = 0;
+  uint32_t tile = 0;
+  bool hasDigits = false;
+  for (size_t i = 0; i <= text.size(); i++)
+  {
+    // The end of the text ends the last row when it has no line break
+    const char character = i < text.size() ? text[i] : '\n';
+    if (character >= '0' && character <= '9')
+    {
+      tile = tile * 10 + (character - '0');
+      if (tile > UINT16_MAX)
+      {
+        error = "tile index too large on row " + std::to_string(height + 1);
+        return false;
+      }
+      hasDigits = true;
+    }
+    else if (character == ',' || character == '\n')
+    {
+      if (hasDigits)
+      {
+        tiles.push_back(static_cast<uint16_t>(tile));
+        rowWidth++;
+      }
+      tile = 0;
+      hasDigits = false;
+
+      if (character == '\n' && rowWidth > 0)
+      {
+        if (height > 0 && rowWidth != width)
+        {
+          error = "row " + std::to_string(height + 1) + " has " + std::to_string(rowWidth) +
+                  " tiles instead of " + std::to_string(width);
+          return false;
+        }
+        width = rowWidth;
+        height++;
+        rowWidth = 0;
+      }
+    }
+    else if (character != '\r' && character != ' ')
+    {
+      error = std::string("unexpected character '") + character + "' on row " + std::to_string(height + 1);
+      return false;
+    }
+  }
+  return true;
+}
+
+// LZ4 block format: sequences of literals followed by a match copied from the
+// output already decoded. A sequence starts with a token holding the literal
+// length in its high 4 bits and the match length minus 4 in its low 4 bits,
+// 15 meaning more length bytes follow. The last sequence only has literals.
+const size_t LZ4_MIN_MATCH = 4;
+const size_t LZ4_LAST_LITERALS = 5; // The last 5 bytes are always literals
+const size_t LZ4_MATCH_LIMIT = 12;  // The last match starts at least 12 bytes before the end
+const size_t LZ4_MAX_OFFSET = 65535;
+const int LZ4_HASH_BITS = 12;
+
+static void WriteLz4Length(std::vector<uint8_t> &output, size_t length)
+{
+  for (; length >= 255; length -= 255)
+  {
+    output.push_back(255);
+  }
+  output.push_back(static_cast<uint8_t>(length));
+}
+
+static void WriteLz4Sequence(std::vector<uint8_t> &output, const uint8_t *literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+  const size_t matchCode = matchLength ? matchLength - LZ4_MIN_MATCH : 0;
+  output.push_back(static_cast<uint8_t>((std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(matchCode, 15)));
+  if (numLiterals >= 15)
+  {
+    WriteLz4Length(output, numLiterals - 15);
+  }
+  output.insert(output.end(), literals, literals + numLiterals);
+  if (matchLength == 0)
+  {
+    return;
+  }
+  output.push_back(static_cast<uint8_t>(offset));
+  output.push_back(static_cast<uint8_t>(offset >> 8));
+  if (matchCode >= 15)
+  {
+    WriteLz4Length(output, matchCode - 15);
+  }
+}
+
+static uint32_t Read32(const uint8_t *bytes)
+{
+  uint32_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+std::vector<uint8_t> Lz4Compress(const uint8_t *input, size_t inputSize)
+{
+  std::vector<uint8_t> output;
+  output.reserve(inputSize / 2 + 16);
+
+  // Last position + 1 of each hashed 4 bytes, 0 for none
+  std::vector<uint32_t> positions(1 << LZ4_HASH_BITS, 0);
+  size_t anchor = 0;
+  size_t i = 0;
+  const size_t matchStartLimit = inputSize > LZ4_MATCH_LIMIT ? inputSize - LZ4_MATCH_LIMIT : 0;
+  while (i < matchStartLimit)
+  {
+    const uint32_t sequence = Read32(input + i);
+    const uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+    const size_t candidate = positions[hash];
+    positions[hash] = static_cast<uint32_t>(i + 1);
+
+    if (candidate == 0 || i + 1 - candidate > LZ4_MAX_OFFSET || Read32(input + candidate - 1) != sequence)
+    {
+      i++;
+      continue;
+    }
+
+    const size_t matchStart = candidate - 1;
+    size_t matchLength = LZ4_MIN_MATCH;
+    while (i + matchLength < inputSize - LZ4_LAST_LITERALS && input[matchStart + matchLength] == input[i + matchLength])
+    {
+      matchLength++;
+    }
+    WriteLz4Sequence(output, input + anchor, i - anchor, i - matchStart, matchLength);
+    i += matchLength;
+    anchor = i;
+  }
+  WriteLz4Sequence(output, input + anchor, inputSize - anchor, 0, 0);
+  return output;
+}
+
+static bool ReadLz4Length(const uint8_t *input, size_t inputSize, size_t &position, size_t &length)
+{
+  uint8_t byte;
+  do
+  {
+    if (position >= inputSize)
+    {
+      return false;
+    }
+    byte = input[position++];
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool Lz4Decompress(const uint8_t *input, size_t inputSize, uint8_t *output, size_t outputSize)
+{
+  size_t in = 0;
+  size_t out = 0;
+  while (in < inputSize)
+  {
+    const uint8_t token = input[in++];
+
+    size_t numLiterals = token >> 4;
+    if (numLiterals == 15 && !ReadLz4Length(input, inputSize, in, numLiterals))
+    {
+      return false;
+    }
+    if (numLiterals > inputSize - in || numLiterals > outputSize - out)
+    {
+      return false;
+    }
+    std::memcpy(output + out, input + in, numLiterals);
+    in += numLiterals;
+    out += numLiterals;
+
+    if (in == inputSize)
+    {
+      break; // Last sequence
+    }
+
+    if (inputSize - in < 2)
+    {
+      return false;
+    }
+    const size_t offset = input[in] | (input[in + 1] << 8);
+    in += 2;
+    size_t matchLength = token & 15;
+    if (matchLength == 15 && !ReadLz4Length(input, inputSize, in, matchLength))
+    {
+      return false;
+    }
+    matchLength += LZ4_MIN_MATCH;
+    if (offset == 0 || offset > out || matchLength > outputSize - out)
+    {
+      return false;
+    }
+    // Byte by byte, the match may overlap the bytes it produces
+    for (size_t j = 0; j < matchLength; j++, out++)
+    {
+      output[out] = output[out - offset];
+    }
+  }
+  return out == outputSize;
+}
+
+bool WriteBinaryTilemap(const std::string &path, int width, int height, const std::vector<std::vector<uint16_t>> &layers,
+                        bool isCompressed, std::string &error)
+{
+  const size_t layerBytes = static_cast<size_t>(width) * height * sizeof(uint16_t);
+  std::vector<std::vector<uint8_t>> layerData;
+  for (const auto &layer : layers)
+  {
+    if (layer.size() != static_cast<size_t>(width) * height)
+    {
+      error = "the layers don't have the same size";
+      return false;
+    }
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(layer.data());
+    if (isCompressed)
+    {
+      layerData.push_back(Lz4Compress(bytes, layerBytes));
+    }
+    else
+    {
+      layerData.emplace_back(bytes, bytes + layerBytes);
+    }
+  }
+
+  TilemapFileHeader header = {};
+  std::memcpy(header.magic, TILEMAP_BINARY_MAGIC, sizeof(header.magic));
+  header.version = TILEMAP_BINARY_VERSION;
+  header.numLayers = static_cast<uint16_t>(layers.size());
+  header.width = width;
+  header.height = height;
+
+  std::vector<TilemapLayerEntry> entries(layers.size());
+  uint64_t offset = sizeof(header) + entries.size() * sizeof(TilemapLayerEntry);
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    offset = (offset + 7) & ~uint64_t(7);
+    entries[i].offset = offset;
+    entries[i].size = static_cast<uint32_t>(layerData[i].size());
+    entries[i].flags = isCompressed ? TILEMAP_LAYER_COMPRESSED : 0;
+    offset += layerData[i].size();
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+  {
+    error = "can't open the file";
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(TilemapLayerEntry));
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    const char padding[8] = {};
+    file.write(padding, entries[i].offset - static_cast<uint64_t>(file.tellp()));
+    file.write(reinterpret_cast<const char *>(layerData[i].data()), layerData[i].size());
+  }
+  if (!file)
+  {
+    error = "can't write the file";
+    return false;
+  }
+  return true;
+}
+
+BinaryTilemapFile::~BinaryTilemapFile()
+{
+  Close();
+}
+
+bool BinaryTilemapFile::Open(const std::string &path, std::string &error)
+{
+  Close();
+  error.clear();
+  isMissing = false;
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    isMissing = errno == ENOENT;
+    error = std::string("can't open the file: ") + std::strerror(errno);
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(TilemapFileHeader))
+  {
+    close(fd);
+    error = "file too small";
+    return false;
+  }
+  mappingSize = status.st_size;
+  mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    mapping = nullptr;
+    error = "can't map the file";
+    return false;
+  }
+
+  const uint8_t *bytes = static_cast<const uint8_t *>(mapping);
+  header = reinterpret_cast<const TilemapFileHeader *>(bytes);
+  layers = reinterpret_cast<const TilemapLayerEntry *>(bytes + sizeof(TilemapFileHeader));
+  if (std::memcmp(header->magic, TILEMAP_BINARY_MAGIC, sizeof(header->magic)) != 0 || header->version != TILEMAP_BINARY_VERSION)
+  {
+    error = "not a binary tilemap, or from another version";
+    Close();
+    return false;
+  }
+  if (mappingSize < sizeof(TilemapFileHeader) + header->numLayers * sizeof(TilemapLayerEntry))
+  {
+    error = "truncated layer table";
+    Close();
+    return false;
+  }
+
+  // Bounded before anything is sized after them: the tilemap holds them in int,
+  // and a compressed layer is decompressed into width * height tiles
+  const uint64_t numTiles = static_cast<uint64_t>(header->width) * header->height;
+  if (numTiles == 0 || numTiles > TILEMAP_MAX_TILES)
+  {
+    error = "invalid size " + std::to_string(header->width) + "x" + std::to_string(header->height);
+    Close();
+    return false;
+  }
+
+  const uint64_t layerBytes = numTiles * sizeof(uint16_t);
+  for (int layer = 0; layer < header->numLayers; layer++)
+  {
+    const TilemapLayerEntry &entry = layers[layer];
+    const bool isSizeValid = IsLayerCompressed(layer) || entry.size == layerBytes;
+    if (!isSizeValid || entry.offset % alignof(uint16_t) != 0 || entry.offset > mappingSize || entry.size > mappingSize - entry.offset)
+    {
+      error = "invalid layer " + std::to_string(layer);
+      Close();
+      return false;
+    }
+  }
+  return true;
+}
+
+void BinaryTilemapFile::Close()
+{
+  if (mapping)
+  {
+    munmap(mapping, mappingSize);
+  }
+  mapping = nullptr;
+  mappingSize = 0;
+  header = nullptr;
+  layers = nullptr;
+}
+
+uint16_t *BinaryTilemapFile::GetLayerTiles(int layer)
+{
+  return reinterpret_cast<uint16_t *>(static_cast<uint8_t *>(mapping) + layers[layer].offset);
+}
+
+bool BinaryTilemapFile::DecompressLayer(int layer, std::vector<uint16_t> &tiles) const
+{
+  tiles.resize(static_cast<size_t>(header->width) * header->height);
+  const uint8_t *data = static_cast<const uint8_t *>(mapping) + layers[layer].offset;
+  return Lz4Decompress(data, layers[layer].size, reinterpret_cast<uint8_t *>(tiles.data()), tiles.size() * sizeof(uint16_t));
+}
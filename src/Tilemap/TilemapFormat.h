@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary tilemap (.tmb), written by tools/TilemapConverter out of CSV maps.
+// Little-endian, as the game only runs on little-endian machines:
+//   TilemapFileHeader
+//   TilemapLayerEntry[numLayers]
+//   the tiles of each layer, row after row, as uint16_t, starting on an 8 bytes boundary.
+//   A compressed layer holds an LZ4 block instead, decompressing to the same tiles.
+// Uncompressed layers are used right inside the memory mapped file, without copy.
+
+const char TILEMAP_BINARY_MAGIC[4] = {'T', 'M', 'B', '1'};
+const uint16_t TILEMAP_BINARY_VERSION = 1;
+// Largest width * height accepted when reading a map, 32 MB of tiles per layer
+const uint32_t TILEMAP_MAX_TILES = 1 << 24;
+
+// TilemapLayerEntry::flags
+const uint32_t TILEMAP_LAYER_COMPRESSED = 1 << 0;
+
+struct TilemapFileHeader
+{
+  char magic[4];
+  uint16_t version;
+  uint16_t numLayers;
+  uint32_t width;
+  uint32_t height;
+};
+
+struct TilemapLayerEntry
+{
+  uint64_t offset; // From the start of the file
+  uint32_t size;   // Bytes stored in the file
+  uint32_t flags;
+};
+
+// Parses comma separated tile indices, one line per row of tiles
+bool ParseTilemapCsv(const std::string &text, std::vector<uint16_t> &tiles, int &width, int &height, std::string &error);
+
+// Compresses into the LZ4 block format
+std::vector<uint8_t> Lz4Compress(const uint8_t *input, size_t inputSize);
+// Returns false unless the block decompresses to exactly outputSize bytes
+bool Lz4Decompress(const uint8_t *input, size_t inputSize, uint8_t *output, size_t outputSize);
+
+// layers holds width * height tiles each
+bool WriteBinaryTilemap(const std::string &path, int width, int height, const std::vector<std::vector<uint16_t>> &layers,
+                        bool isCompressed, std::string &error);
+
+// Binary tilemap file mapped in memory.
+// The mapping is private: writing to the tiles of a layer only copies the pages
+// written to, the file itself is never modified.
+class BinaryTilemapFile
+{
+private:
+  void *mapping = nullptr;
+  size_t mappingSize = 0;
+  const TilemapFileHeader *header = nullptr;
+  const TilemapLayerEntry *layers = nullptr;
+  bool isMissing = false;
+
+public:
+  BinaryTilemapFile() = default;
+  BinaryTilemapFile(const BinaryTilemapFile &) = delete;
+  BinaryTilemapFile &operator=(const BinaryTilemapFile &) = delete;
+  ~BinaryTilemapFile();
+
+  // Maps and validates the file, returns false with the reason in error
+  bool Open(const std::string &path, std::string &error);
+  void Close();
+  // Whether the last Open failed because the file doesn't exist
+  bool IsMissing() const { return isMissing; }
+
+  int GetWidth() const { return header->width; }
+  int GetHeight() const { return header->height; }
+  int GetNumLayers() const { return header->numLayers; }
+  bool IsLayerCompressed(int layer) const { return layers[layer].flags & TILEMAP_LAYER_COMPRESSED; }
+
+  // Tiles of an uncompressed layer, inside the mapping
+  uint16_t *GetLayerTiles(int layer);
+  bool DecompressLayer(int layer, std::vector<uint16_t> &tiles) const;
+};
@@ -0,0 +1,141 @@
+// Packs every PNG image of a directory into the pages of a texture atlas, see Atlas.h.
+// Usage: atlaspacker <image directory> <atlas list, e.g. assets/atlas/atlas.txt>
+// The pages are written next to the list, named after it: atlas-0.png, atlas-1.png...
+#include "../../src/AssetStore/Atlas.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "../../libs/imgui/imstb_rectpack.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Image
+{
+  std::string name;
+  SDL_Surface *surface;
+};
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <image directory> <atlas list>" << std::endl;
+    return 1;
+  }
+  const std::filesystem::path imageDirectory = argv[1];
+  const std::filesystem::path listPath = argv[2];
+
+  // Sorted by name, so that packing the same images always gives the same atlas
+  std::vector<std::filesystem::path> imagePaths;
+  for (const auto &entry : std::filesystem::directory_iterator(imageDirectory))
+  {
+    if (entry.is_regular_file() && entry.path().extension() == ".png")
+    {
+      imagePaths.push_back(entry.path());
+    }
+  }
+  std::sort(imagePaths.begin(), imagePaths.end());
+
+  std::vector<Image> images;
+  std::vector<stbrp_rect> rects;
+  for (const auto &imagePath : imagePaths)
+  {
+    SDL_Surface *surface = IMG_Load(imagePath.string().c_str());
+    if (surface == NULL)
+    {
+      std::cerr << "Error loading " << imagePath.string() << ": " << IMG_GetError() << std::endl;
+      return 1;
+    }
+    if (surface->w + 2 * ATLAS_PADDING > ATLAS_PAGE_SIZE || surface->h + 2 * ATLAS_PADDING > ATLAS_PAGE_SIZE)
+    {
+      std::cerr << imagePath.string() << " doesn't fit in a " << ATLAS_PAGE_SIZE << "x" << ATLAS_PAGE_SIZE << " page" << std::endl;
+      return 1;
+    }
+    // Copy the pixels as they are, alpha included, instead of blending them over the page
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+
+    stbrp_rect rect = {};
+    rect.id = static_cast<int>(images.size());
+    rect.w = static_cast<stbrp_coord>(surface->w + 2 * ATLAS_PADDING);
+    rect.h = static_cast<stbrp_coord>(surface->h + 2 * ATLAS_PADDING);
+    rects.push_back(rect);
+    images.push_back({imagePath.stem().string(), surface});
+  }
+
+  std::filesystem::create_directories(listPath.parent_path());
+  std::ofstream list(listPath);
+  if (!list)
+  {
+    std::cerr << "Error opening " << listPath.string() << std::endl;
+    return 1;
+  }
+
+  // Fill a page with as many images as it takes, the ones left over go to the next page
+  std::vector<stbrp_node> nodes(ATLAS_PAGE_SIZE);
+  int pageIndex = 0;
+  while (!rects.empty())
+  {
+    stbrp_context context;
+    stbrp_init_target(&context, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, nodes.data(), static_cast<int>(nodes.size()));
+    stbrp_pack_rects(&context, rects.data(), static_cast<int>(rects.size()));
+
+    std::vector<stbrp_rect> packedRects;
+    std::vector<stbrp_rect> leftRects;
+    int pageWidth = 0;
+    int pageHeight = 0;
+    for (const stbrp_rect &rect : rects)
+    {
+      if (rect.was_packed)
+      {
+        packedRects.push_back(rect);
+        pageWidth = std::max(pageWidth, rect.x + rect.w);
+        pageHeight = std::max(pageHeight, rect.y + rect.h);
+      }
+      else
+      {
+        leftRects.push_back(rect);
+      }
+    }
+
+    // The page only covers the area used by the images
+    SDL_Surface *page = SDL_CreateRGBSurfaceWithFormat(0, pageWidth, pageHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (page == NULL)
+    {
+      std::cerr << "Error creating a page: " << SDL_GetError() << std::endl;
+      return 1;
+    }
+
+    const std::string pageName = listPath.stem().string() + "-" + std::to_string(pageIndex) + ".png";
+    list << "page " << pageName << "\n";
+    for (const stbrp_rect &rect : packedRects)
+    {
+      const Image &image = images[rect.id];
+      SDL_Rect destination = {rect.x + ATLAS_PADDING, rect.y + ATLAS_PADDING, image.surface->w, image.surface->h};
+      SDL_BlitSurface(image.surface, NULL, page, &destination);
+      list << "sprite " << image.name << " " << pageIndex << " " << destination.x << " " << destination.y << " "
+           << image.surface->w << " " << image.surface->h << "\n";
+    }
+
+    const std::string pagePath = (listPath.parent_path() / pageName).string();
+    if (IMG_SavePNG(page, pagePath.c_str()) != 0)
+    {
+      std::cerr << "Error writing " << pagePath << ": " << IMG_GetError() << std::endl;
+      return 1;
+    }
+    std::cout << pagePath << ": " << packedRects.size() << " images, " << pageWidth << "x" << pageHeight << std::endl;
+    SDL_FreeSurface(page);
+
+    rects = leftRects;
+    pageIndex++;
+  }
+
+  for (const Image &image : images)
+  {
+    SDL_FreeSurface(image.surface);
+  }
+  return 0;
+}
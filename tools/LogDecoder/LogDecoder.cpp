@@ -0,0 +1,85 @@
+// Turns a binary log file written with Logger::SetBinaryFileOutput into text.
+// Usage: logdecoder <binary log file>
+#include "../../src/Logger/Logger.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char *LogPrefix(uint8_t type)
+{
+  return type == LOG_ERROR ? "ERR: [" : "LOG: [";
+}
+
+template <typename TValue>
+static bool Read(std::istream &input, TValue &value)
+{
+  return static_cast<bool>(input.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <binary log file>" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  char magic[sizeof(LOG_BINARY_MAGIC)];
+  if (!input.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC)))
+  {
+    std::cerr << argv[1] << " is not a binary log file" << std::endl;
+    return 1;
+  }
+
+  // [index = format id]
+  std::vector<std::string> formats;
+  std::string arguments;
+
+  char tag;
+  while (input.get(tag))
+  {
+    if (tag == LOG_BINARY_FORMAT)
+    {
+      uint32_t formatId;
+      uint16_t length;
+      if (!Read(input, formatId) || !Read(input, length))
+      {
+        break;
+      }
+      if (formatId >= formats.size())
+      {
+        formats.resize(formatId + 1);
+      }
+      formats[formatId].resize(length);
+      input.read(&formats[formatId][0], length);
+    }
+    else if (tag == LOG_BINARY_RECORD)
+    {
+      uint8_t type;
+      int64_t time;
+      uint32_t formatId;
+      uint32_t length;
+      if (!Read(input, type) || !Read(input, time) || !Read(input, formatId) || !Read(input, length))
+      {
+        break;
+      }
+      arguments.resize(length);
+      input.read(&arguments[0], length);
+
+      const std::string &format = formatId < formats.size() ? formats[formatId] : "<unknown format>";
+      const std::chrono::system_clock::time_point timePoint{std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time))};
+      std::cout << LogPrefix(type) << DateTimeToString(timePoint) << "]: "
+                << FormatLogArguments(format.c_str(), arguments.data(), arguments.size()) << "\n";
+    }
+    else
+    {
+      std::cerr << "Corrupted log file" << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Converts CSV tilemaps into a binary tilemap, see TilemapFormat.h. Each CSV map becomes a layer.
+// Usage: tilemapconverter [--compress] <output .tmb> <layer .map>...
+//   --compress  stores the layers as LZ4 blocks, smaller but decompressed when loaded
+#include "../../src/Tilemap/TilemapFormat.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+  bool isCompressed = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--compress")
+    {
+      isCompressed = true;
+    }
+    else
+    {
+      paths.push_back(argument);
+    }
+  }
+  if (paths.size() < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " [--compress] <output .tmb> <layer .map>..." << std::endl;
+    return 1;
+  }
+
+  std::vector<std::vector<uint16_t>> layers;
+  int width = 0;
+  int height = 0;
+  for (size_t i = 1; i < paths.size(); i++)
+  {
+    std::ifstream file(paths[i]);
+    if (!file)
+    {
+      std::cerr << "Error opening " << paths[i] << std::endl;
+      return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::vector<uint16_t> tiles;
+    int layerWidth;
+    int layerHeight;
+    std::string error;
+    if (!ParseTilemapCsv(text.str(), tiles, layerWidth, layerHeight, error))
+    {
+      std::cerr << "Error parsing " << paths[i] << ": " << error << std::endl;
+      return 1;
+    }
+    if (!layers.empty() && (layerWidth != width || layerHeight != height))
+    {
+      std::cerr << paths[i] << " is " << layerWidth << "x" << layerHeight << " while the first layer is "
+                << width << "x" << height << std::endl;
+      return 1;
+    }
+    width = layerWidth;
+    height = layerHeight;
+    layers.push_back(std::move(tiles));
+  }
+
+  std::string error;
+  if (!WriteBinaryTilemap(paths[0], width, height, layers, isCompressed, error))
+  {
+    std::cerr << "Error writing " << paths[0] << ": " << error << std::endl;
+    return 1;
+  }
+  std::cout << paths[0] << ": " << width << "x" << height << " tiles, " << layers.size() << " layers"
+            << (isCompressed ? ", compressed" : "") << std::endl;
+  return 0;
+}